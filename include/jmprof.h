@@ -55,10 +55,32 @@
 
 #define MAX_BACKTRACE_COUNT  32
 #define MAX_BUFFER_SIZE      2048
+#define MAX_COLD_COUNT       64
+#define MAX_COUNTER_COUNT    8
+#define MAX_EVENT_COUNT      64
+#define MAX_FILTERED_COUNT   (1 << 20)
+#define MAX_LATENCY_COUNT    256
+#define MAX_LIFETIME_COUNT   13
+#define MAX_MARK_COUNT       128
+#define MAX_MODULE_COUNT     256
+#define MAX_NODE_COUNT       16
+#define MAX_PAGE_COUNT       512
+#define MAX_PENDING_COUNT    256
+#define MAX_PROCESS_COUNT    256
+#define MAX_READ_SIZE        65536
 #define MAX_REGION_COUNT     128
+#define MAX_SIZE_CLASS_COUNT 65
+#define MAX_SLOT_COUNT       256
+#define MAX_SNAPSHOT_COUNT   64
+#define MAX_THREAD_NAME_SIZE 16
+#define MAX_TOP_SITE_COUNT   5
 
+#define HEAP_ALIGNMENT       (1UL << 20)
 #define MMAP_ROW_SIZE        512
 
+#define SAMPLE_FILE_MAGIC    "jmprofpm"
+#define SAMPLE_FILE_VERSION  2
+
 /* clang-format on */
 
 /* Typedefs ===============================================================> */
@@ -67,22 +89,152 @@ typedef enum jmOpcode_ {
     JM_OPCODE_UNKNOWN,
     JM_OPCODE_ALLOC          = 'a',
     JM_OPCODE_BACKTRACE      = 'b',
+    JM_OPCODE_REALLOC        = 'c',
+    JM_OPCODE_FREE_TIME      = 'd',
+    JM_OPCODE_THREAD_EXIT    = 'e',
     JM_OPCODE_FREE           = 'f',
+    JM_OPCODE_TIMING         = 'g',
+    JM_OPCODE_HISTOGRAM      = 'h',
+    JM_OPCODE_PROCESS        = 'i',
+    JM_OPCODE_MARK           = 'k',
+    JM_OPCODE_FILTERED       = 'l',
     JM_OPCODE_MODULE         = 'm',
+    JM_OPCODE_COLD           = 'o',
+    JM_OPCODE_MAP            = 'p',
+    JM_OPCODE_UNMAP          = 'q',
     JM_OPCODE_REGION         = 'r',
+    JM_OPCODE_SCAN           = 's',
+    JM_OPCODE_THREAD         = 't',
     JM_OPCODE_UPDATE_MODULES = 'u',
+    JM_OPCODE_REMAP          = 'w',
     JM_OPCODE_EXEC_PATH      = 'x'
 } jmOpcode;
 
+typedef enum jmAllocKind_ {
+    JM_ALLOC_KIND_MALLOC,
+    JM_ALLOC_KIND_NEW,
+    JM_ALLOC_KIND_NEW_ARRAY,
+    JM_ALLOC_KIND_NEW_ALIGNED,
+    JM_ALLOC_KIND_NEW_ARRAY_ALIGNED,
+    JM_ALLOC_KIND_COUNT
+} jmAllocKind;
+
+typedef enum jmControl_ {
+    JM_CONTROL_PAUSE,
+    JM_CONTROL_RESUME,
+    JM_CONTROL_MARK,
+    JM_CONTROL_DUMP,
+    JM_CONTROL_COUNT
+} jmControl;
+
+typedef enum jmSampleKind_ {
+    JM_SAMPLE_KIND_SAMPLE,
+    JM_SAMPLE_KIND_LOST,
+    JM_SAMPLE_KIND_THROTTLE,
+    JM_SAMPLE_KIND_UNTHROTTLE,
+    JM_SAMPLE_KIND_TOTAL,
+    JM_SAMPLE_KIND_COUNT
+} jmSampleKind;
+
+typedef struct jmEvent_ {
+    jmOpcode opcode;
+    jmAllocKind kind;
+    const void *ptr, *old_ptr, *caller;
+    size_t size, old_size;
+    uint64_t duration;
+} jmEvent;
+
 typedef struct jmRegion_ {
     void *start, *end;
 } jmRegion;
 
+/*
+    NOTE: A sample file starts with a header, followed by the name of 
+    each event counter (`MAX_BUFFER_SIZE` bytes each) and the samples.
+
+    It ends with a `JM_SAMPLE_KIND_TOTAL` record for each event counter,
+    which holds the value of the counter in `weight`, and the time it was
+    enabled and running (in nanoseconds) in `addr` and `phys_addr`.
+
+    The NUMA node of the page at `addr` is in `node` (-1 if unknown),
+    and that of the CPU the sample was taken on is in `cpu_node`.
+*/
+
+typedef struct jmSampleHeader_ {
+    char magic[8];
+    uint32_t version, counter_count;
+} jmSampleHeader;
+
+typedef struct jmSample_ {
+    uint64_t timestamp;
+    uint64_t ip, addr, phys_addr, weight;
+    uint32_t pid, tid;
+    uint16_t kind, counter;
+    int16_t node, cpu_node;
+} jmSample;
+
 /* Public Function Prototypes =============================================> */
 
 /* (from src/backtrace.c) =================================================> */
 
-void jm_backtrace_unwind(bool is_alloc, const void *ptr, size_t size);
+void jm_backtrace_init(void);
+void jm_backtrace_deinit(void);
+
+void jm_backtrace_atfork_prepare(void);
+void jm_backtrace_atfork_parent(void);
+
+void jm_backtrace_lock(void);
+void jm_backtrace_unlock(void);
+
+bool jm_backtrace_unwind(jmEvent event);
+void jm_backtrace_time_free(const void *ptr, uint64_t duration);
+void jm_backtrace_set_names_dirty(void);
+
+/* (from src/control.c) ===================================================> */
+
+void jm_control_init(void);
+void jm_control_deinit(void);
+
+bool jm_control_is_paused(void);
+
+/*
+    NOTE: `jmprof_control()` is exported from `libjmprof.so`, so that a 
+    program can pause, resume or mark the recording at any point, e.g.
+
+    void (*fn)(int, const char *) = dlsym(RTLD_DEFAULT, "jmprof_control");
+
+    if (fn != NULL) fn(JM_CONTROL_RESUME, "load-test");
+*/
+
+void jmprof_control(int command, const char *label);
+
+/* (from src/filter.c) ====================================================> */
+
+void jm_filter_init(void);
+void jm_filter_deinit(void);
+
+void jm_filter_atfork_prepare(void);
+void jm_filter_atfork_parent(void);
+void jm_filter_atfork_child(void);
+
+void jm_filter_lock_blocks(void);
+void jm_filter_unlock_blocks(void);
+
+bool jm_filter_accept(jmEvent *event, size_t *size);
+void jm_filter_set_dirty(void);
+void jm_filter_set_names_dirty(void);
+
+/* (from src/histogram.c) =================================================> */
+
+void jm_histogram_init(void);
+void jm_histogram_deinit(void);
+
+void jm_histogram_atfork_prepare(void);
+void jm_histogram_atfork_parent(void);
+void jm_histogram_atfork_child(void);
+
+bool jm_histogram_is_enabled(void);
+void jm_histogram_count(jmEvent event);
 
 /* (from src/preload.c) ===================================================> */
 
@@ -94,9 +246,24 @@ void jm_preload_deinit(void);
 void jm_tracker_init(void);
 void jm_tracker_deinit(void);
 
+void jm_tracker_atfork_prepare(void);
+void jm_tracker_atfork_parent(void);
+void jm_tracker_atfork_child(void);
+
+void jm_tracker_lock(void);
+void jm_tracker_unlock(void);
+
+bool jm_tracker_is_following(void);
+bool jm_tracker_is_timing(void);
+
+uint64_t jm_tracker_get_ticks(void);
+void jm_tracker_add_overhead(uint64_t ticks);
+
 void jm_tracker_fprintf(const char* format, ...);
+void jm_tracker_write(const char *buffer, size_t size);
 void jm_tracker_set_dirty(bool value);
 void jm_tracker_update_mappings(void);
+void jm_tracker_scan_regions(void);
 
 /* ========================================================================> */
 
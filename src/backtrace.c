@@ -22,8 +22,13 @@
 
 /* Includes ===============================================================> */
 
+#define _GNU_SOURCE
+
 #include <malloc.h>
 
+#include <sys/prctl.h>
+#include <unistd.h>
+
 #define UNW_LOCAL_ONLY
 #include <libunwind.h>
 
@@ -33,18 +38,165 @@
 
 static pthread_mutex_t unwind_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* ========================================================================> */
+
+static pthread_key_t unwind_key;
+
+// NOTE: Set while the current thread holds the stream on its own
+static pthread_key_t lock_key;
+
+/*
+    NOTE: The value of `thread_key` is the generation of thread names
+    that the current thread has last written, which is bumped every 
+    time a thread is renamed.
+*/
+
+static pthread_key_t thread_key;
+
+static uintptr_t name_generation = 1;
+
+/* Private Function Prototypes ============================================> */
+
+static void jm_backtrace_name_thread(void);
+static void jm_backtrace_exit_thread(void *value);
+
 /* Public Functions =======================================================> */
 
-void jm_backtrace_unwind(bool is_alloc, const void *ptr, size_t size) {
+void jm_backtrace_init(void) {
+    pthread_key_create(&unwind_key, NULL);
+    pthread_key_create(&lock_key, NULL);
+    pthread_key_create(&thread_key, jm_backtrace_exit_thread);
+}
+
+void jm_backtrace_deinit(void) {
+    pthread_key_delete(thread_key);
+    pthread_key_delete(lock_key);
+    pthread_key_delete(unwind_key);
+}
+
+/* ========================================================================> */
+
+void jm_backtrace_atfork_prepare(void) {
     pthread_mutex_lock(&unwind_mutex);
+}
+
+void jm_backtrace_atfork_parent(void) {
+    pthread_mutex_unlock(&unwind_mutex);
+}
+
+/* ========================================================================> */
+
+void jm_backtrace_lock(void) {
+    /*
+        NOTE: A call that releases a block and returns another one (e.g.
+        `realloc()`) holds the stream until its event is written, so that
+        no other thread can record the released block as its own first.
+    */
+
+    pthread_mutex_lock(&unwind_mutex);
+
+    pthread_setspecific(lock_key, &lock_key);
+}
+
+void jm_backtrace_unlock(void) {
+    pthread_setspecific(lock_key, NULL);
+
+    pthread_mutex_unlock(&unwind_mutex);
+}
+
+/* ========================================================================> */
+
+bool jm_backtrace_unwind(jmEvent event) {
+    // NOTE: A failed allocation does not create any block
+    if (event.opcode == JM_OPCODE_ALLOC && event.ptr == NULL) return false;
+
+    /*
+        NOTE: `unw_backtrace()` may call `mmap()` (or any other function
+        we intercept) by itself, which must not be recorded.
+    */
+
+    if (pthread_getspecific(unwind_key) != NULL) return false;
+
+    // NOTE: In "histogram mode", the hooks count the heap events instead
+    if (jm_histogram_is_enabled()) return false;
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    /*
+        NOTE: `event.size` is the number of bytes requested by the caller,
+        which can be smaller than the actual size of the block.
+
+        The size passed to a sized `operator delete` is trusted as is,
+        so that we do not have to look up the block again.
+    */
+
+    bool is_sized_free = (event.opcode == JM_OPCODE_FREE) && (event.size > 0);
+
+    bool is_heap_event = (event.opcode == JM_OPCODE_ALLOC)
+                         || (event.opcode == JM_OPCODE_FREE)
+                         || (event.opcode == JM_OPCODE_REALLOC);
+
+    // NOTE: The length of a memory mapping is known in advance
+    size_t usable_size = event.size;
+
+    if (event.ptr != NULL && is_heap_event && !is_sized_free)
+        usable_size = malloc_usable_size((void *) event.ptr);
+
+    /*
+        NOTE: Filtered events are only counted, and never unwound. A 
+        block resized out of the size filters is written as freed.
+    */
+    if (!jm_filter_accept(&event, &usable_size)) return false;
+
+    /*
+        NOTE: The time spent in the allocator itself is only written on
+        request, after the other fields of an allocation.
+    */
+
+    // NOTE: `" <UINT64_MAX>"` is 21 characters long
+    char duration[32] = { '\0' };
+
+    if (jm_tracker_is_timing()
+        && (event.opcode == JM_OPCODE_ALLOC
+            || event.opcode == JM_OPCODE_REALLOC))
+        (void) REENTRANT_SNPRINTF(duration,
+                                  sizeof duration,
+                                  " %ju",
+                                  event.duration);
+
+    pthread_setspecific(unwind_key, &unwind_key);
+
+    bool is_locked = (pthread_getspecific(lock_key) != NULL);
+
+    if (!is_locked) pthread_mutex_lock(&unwind_mutex);
 
     {
-        size = malloc_usable_size((void *) ptr);
+        jm_backtrace_name_thread();
 
-        jm_tracker_fprintf("%c 0x%jx %ju\n",
-                           (is_alloc ? JM_OPCODE_ALLOC : JM_OPCODE_FREE),
-                           (uintptr_t) ptr,
-                           size);
+        if (event.opcode == JM_OPCODE_REALLOC
+            || event.opcode == JM_OPCODE_REMAP) {
+            // `[...] <OLD_ADDRESS> <OLD_USABLE_SIZE> [<DURATION>]`
+            jm_tracker_fprintf("%c 0x%jx %ju %ju %d %d 0x%jx %ju%s\n",
+                               event.opcode,
+                               (uintptr_t) event.ptr,
+                               usable_size,
+                               event.size,
+                               gettid(),
+                               event.kind,
+                               (uintptr_t) event.old_ptr,
+                               event.old_size,
+                               duration);
+        } else {
+            // `<OPERATION> <ADDRESS> <SIZE> <REQUESTED_SIZE> <TID> <KIND>`
+            jm_tracker_fprintf("%c 0x%jx %ju %ju %d %d%s\n",
+                               event.opcode,
+                               (uintptr_t) event.ptr,
+                               usable_size,
+                               event.size,
+                               gettid(),
+                               event.kind,
+                               duration);
+        }
 
         void *traces[MAX_BACKTRACE_COUNT];
 
@@ -55,5 +207,79 @@ void jm_backtrace_unwind(bool is_alloc, const void *ptr, size_t size) {
             jm_tracker_fprintf("b 0x%jx\n", traces[i]);
     }
 
+    if (!is_locked) pthread_mutex_unlock(&unwind_mutex);
+
+    /*
+        NOTE: The pages are scanned after the lock is released, so that
+        the other threads can go on recording events in the meantime.
+        The scan takes the lock again for each batch of cold runs, which
+        is why it is left to the next event if the lock is still held.
+    */
+    if (!is_locked) jm_tracker_scan_regions();
+
+    pthread_setspecific(unwind_key, NULL);
+
+    // NOTE: The cost of recording an event, apart from the allocator's
+    if (jm_tracker_is_timing())
+        jm_tracker_add_overhead(jm_tracker_get_ticks() - start);
+
+    return true;
+}
+
+void jm_backtrace_time_free(const void *ptr, uint64_t duration) {
+    /*
+        NOTE: A block is recorded as freed before it is actually freed
+        (so that another thread cannot allocate it again in between), 
+        which is why its duration comes in a record of its own.
+    */
+
+    pthread_mutex_lock(&unwind_mutex);
+
+    // `<OPERATION> <ADDRESS> <TID> <DURATION>`
+    jm_tracker_fprintf("%c 0x%jx %d %ju\n",
+                       JM_OPCODE_FREE_TIME,
+                       (uintptr_t) ptr,
+                       gettid(),
+                       duration);
+
+    pthread_mutex_unlock(&unwind_mutex);
+}
+
+void jm_backtrace_set_names_dirty(void) {
+    __atomic_fetch_add(&name_generation, 1, __ATOMIC_RELAXED);
+}
+
+/* Private Functions ======================================================> */
+
+static void jm_backtrace_name_thread(void) {
+    uintptr_t generation = __atomic_load_n(&name_generation, __ATOMIC_RELAXED);
+
+    if ((uintptr_t) pthread_getspecific(thread_key) == generation) return;
+
+    /*
+        NOTE: A thread is named on its first event, and again after any 
+        thread has been renamed (`prctl()` is a system call, and a thread
+        can be renamed by another one).
+    */
+
+    char name[MAX_THREAD_NAME_SIZE] = { '\0' };
+
+    (void) prctl(PR_GET_NAME, name, 0, 0, 0);
+
+    // `<OPERATION> <ADDRESS> <TID> <NAME>`
+    jm_tracker_fprintf("%c 0x0 %d %s\n", JM_OPCODE_THREAD, gettid(), name);
+
+    pthread_setspecific(thread_key, (void *) generation);
+}
+
+static void jm_backtrace_exit_thread(void *value) {
+    (void) value;
+
+    // NOTE: Only the threads that have written any event are destructed
+    pthread_mutex_lock(&unwind_mutex);
+
+    // `<OPERATION> <ADDRESS> <TID>`
+    jm_tracker_fprintf("%c 0x0 %d\n", JM_OPCODE_THREAD_EXIT, gettid());
+
     pthread_mutex_unlock(&unwind_mutex);
 }
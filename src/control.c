@@ -0,0 +1,216 @@
+/*
+    Copyright (c) 2024 Jaedeok Kim <jdeokkim@protonmail.com>
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included 
+    in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+
+/* Includes ===============================================================> */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sokol_time.h"
+
+#include "jmprof.h"
+
+/* Constants ==============================================================> */
+
+static const char *control_names[JM_CONTROL_COUNT] = {
+    [JM_CONTROL_PAUSE] = "pause",
+    [JM_CONTROL_RESUME] = "resume",
+    [JM_CONTROL_MARK] = "mark",
+    [JM_CONTROL_DUMP] = "dump"
+};
+
+/* Private Variables ======================================================> */
+
+static pthread_once_t control_init_once = PTHREAD_ONCE_INIT;
+static pthread_once_t control_deinit_once = PTHREAD_ONCE_INIT;
+
+/* ========================================================================> */
+
+static struct sigaction old_action;
+static struct sigaction old_dump_action;
+
+/* ========================================================================> */
+
+static volatile sig_atomic_t is_paused = false;
+
+static int control_signal = 0, dump_signal = 0;
+
+/* Private Function Prototypes ============================================> */
+
+static void jm_control_init_(void);
+static void jm_control_deinit_(void);
+
+/* ========================================================================> */
+
+static void jm_control_emit(jmControl command, const char *label);
+static void jm_control_handle_signal(int signum);
+static void jm_control_handle_dump_signal(int signum);
+static int jm_control_install(const char *name,
+                              void (*handler)(int),
+                              struct sigaction *old);
+static int jm_control_parse_signal(const char *name);
+
+/* Public Functions =======================================================> */
+
+void jm_control_init(void) {
+    pthread_once(&control_init_once, jm_control_init_);
+}
+
+void jm_control_deinit(void) {
+    pthread_once(&control_deinit_once, jm_control_deinit_);
+}
+
+/* ========================================================================> */
+
+bool jm_control_is_paused(void) {
+    return __atomic_load_n(&is_paused, __ATOMIC_RELAXED);
+}
+
+/* ========================================================================> */
+
+__attribute__((visibility("default")))
+void jmprof_control(int command, const char *label) {
+    if (command < 0 || command >= JM_CONTROL_COUNT) return;
+
+    if (command == JM_CONTROL_PAUSE)
+        __atomic_store_n(&is_paused, true, __ATOMIC_RELAXED);
+    else if (command == JM_CONTROL_RESUME)
+        __atomic_store_n(&is_paused, false, __ATOMIC_RELAXED);
+
+    jm_control_emit(command, label);
+}
+
+/* Private Functions ======================================================> */
+
+static void jm_control_init_(void) {
+    const char *paused = getenv("JMPROF_PAUSED");
+
+    if (paused != NULL && paused[0] != '\0' && paused[0] != '0')
+        jmprof_control(JM_CONTROL_PAUSE, "JMPROF_PAUSED");
+
+    control_signal = jm_control_install(getenv("JMPROF_SIGNAL"),
+                                        jm_control_handle_signal,
+                                        &old_action);
+
+    dump_signal = jm_control_install(getenv("JMPROF_DUMP_SIGNAL"),
+                                     jm_control_handle_dump_signal,
+                                     &old_dump_action);
+}
+
+static void jm_control_deinit_(void) {
+    if (control_signal > 0)
+        (void) sigaction(control_signal, &old_action, NULL);
+
+    if (dump_signal > 0) (void) sigaction(dump_signal, &old_dump_action, NULL);
+
+    control_signal = 0, dump_signal = 0;
+}
+
+/* ========================================================================> */
+
+static void jm_control_emit(jmControl command, const char *label) {
+    /*
+        NOTE: This function might be called from a signal handler, so it 
+        must not take any locks (like `jm_tracker_fprintf()` does). 
+        
+        A single `write()` of a line shorter than `PIPE_BUF` bytes is 
+        never interleaved with the lines written by other threads.
+    */
+
+    char buffer[MAX_BUFFER_SIZE];
+
+    // `<TIMESTAMP> <OPERATION> <ADDRESS> <COMMAND> <LABEL>`
+    int len = REENTRANT_SNPRINTF(buffer,
+                                 sizeof buffer,
+                                 "%" PRIu64 " %c 0x0 %s %s\n",
+                                 stm_now(),
+                                 JM_OPCODE_MARK,
+                                 control_names[command],
+                                 (label != NULL && label[0] != '\0') ? label
+                                                                     : "-");
+
+    if (len >= sizeof buffer) {
+        len = sizeof buffer - 1;
+
+        buffer[len - 1] = '\n';
+    }
+
+    jm_tracker_write(buffer, len);
+}
+
+static void jm_control_handle_signal(int signum) {
+    (void) signum;
+
+    // NOTE: Each signal toggles between recording and pausing
+    if (jm_control_is_paused())
+        jmprof_control(JM_CONTROL_RESUME, "signal");
+    else
+        jmprof_control(JM_CONTROL_PAUSE, "signal");
+}
+
+static void jm_control_handle_dump_signal(int signum) {
+    (void) signum;
+
+    /*
+        NOTE: The live heap is already known to the interpreter, so all we
+        have to do here is to tell it when to dump it.
+    */
+
+    jm_control_emit(JM_CONTROL_DUMP, "signal");
+}
+
+static int jm_control_install(const char *name,
+                              void (*handler)(int),
+                              struct sigaction *old) {
+    int signum = (name != NULL) ? jm_control_parse_signal(name) : -1;
+
+    if (signum <= 0) return 0;
+
+    struct sigaction action = { .sa_handler = handler,
+                                .sa_flags = SA_RESTART };
+
+    sigemptyset(&action.sa_mask);
+
+    return (sigaction(signum, &action, old) == 0) ? signum : 0;
+}
+
+static int jm_control_parse_signal(const char *name) {
+    char *end = NULL;
+
+    long result = strtol(name, &end, 10);
+
+    if (end != name && *end == '\0') return (result < NSIG) ? result : -1;
+
+    // NOTE: e.g. `SIGUSR1`, `USR1`
+    if (strncmp(name, "SIG", strlen("SIG")) == 0) name += strlen("SIG");
+
+    if (strcmp(name, "USR1") == 0) return SIGUSR1;
+    if (strcmp(name, "USR2") == 0) return SIGUSR2;
+    if (strcmp(name, "HUP") == 0) return SIGHUP;
+
+    return -1;
+}
@@ -0,0 +1,546 @@
+/*
+    Copyright (c) 2024 Jaedeok Kim <jdeokkim@protonmail.com>
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included 
+    in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+
+/* Includes ===============================================================> */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <link.h>
+#include <malloc.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+#include "jmprof.h"
+
+/* Typedefs ===============================================================> */
+
+typedef struct jmModuleRange_ {
+    uintptr_t start, end;
+    bool is_accepted;
+} jmModuleRange;
+
+/* Private Variables ======================================================> */
+
+static pthread_once_t filter_init_once = PTHREAD_ONCE_INIT;
+static pthread_once_t filter_deinit_once = PTHREAD_ONCE_INIT;
+
+/* ========================================================================> */
+
+static pthread_rwlock_t modules_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static pthread_mutex_t blocks_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* ========================================================================> */
+
+static pthread_key_t thread_key;
+
+/* ========================================================================> */
+
+static char exec_path[PATH_MAX + 1];
+
+static const char *include_modules, *exclude_modules;
+static const char *include_threads, *exclude_threads;
+
+static size_t min_size = 0, max_size = SIZE_MAX;
+
+/* ========================================================================> */
+
+static struct jmModuleRanges_ {
+    jmModuleRange buffer[MAX_MODULE_COUNT];
+    size_t count;
+} modules;
+
+/*
+    NOTE: The blocks rejected by the caller or thread filters, so that 
+    their frees (made by any thread, from any module) can be rejected 
+    as well. This is an open-addressing hash set with linear probing, 
+    which never allocates.
+*/
+
+static struct jmFilteredBlocks_ {
+    const void *buffer[MAX_FILTERED_COUNT];
+    size_t count;
+} blocks;
+
+static bool is_enabled = false, is_dirty = true;
+
+/*
+    NOTE: The value of `thread_key` is the generation of thread names
+    that the decision was made for (shifted to the left by one), with 
+    the lowest bit set if the thread is accepted.
+*/
+
+static uintptr_t name_generation = 1;
+
+/* ========================================================================> */
+
+static struct jmFilterCounters_ {
+    size_t alloc_count, alloc_total;
+    size_t free_count, free_total;
+    size_t map_count, map_total;
+} counters;
+
+/* Private Function Prototypes ============================================> */
+
+static void jm_filter_init_(void);
+static void jm_filter_deinit_(void);
+
+/* ========================================================================> */
+
+static bool jm_filter_accept_caller(const void *caller);
+static bool jm_filter_accept_thread(void);
+static bool jm_filter_add_block(const void *ptr);
+static bool jm_filter_remove_block(const void *ptr);
+static void jm_filter_count(const jmEvent *event, size_t size);
+static void jm_filter_update_modules(void);
+
+/* ========================================================================> */
+
+static int
+dl_iterate_phdr_callback(struct dl_phdr_info *info, size_t size, void *data);
+
+static size_t hash_pointer(const void *ptr);
+static bool match_any(const char *name, const char *patterns);
+
+/* Public Functions =======================================================> */
+
+void jm_filter_init(void) {
+    pthread_once(&filter_init_once, jm_filter_init_);
+}
+
+void jm_filter_deinit(void) {
+    pthread_once(&filter_deinit_once, jm_filter_deinit_);
+}
+
+/* ========================================================================> */
+
+void jm_filter_atfork_prepare(void) {
+    pthread_rwlock_wrlock(&modules_lock);
+}
+
+void jm_filter_atfork_parent(void) {
+    pthread_rwlock_unlock(&modules_lock);
+}
+
+void jm_filter_atfork_child(void) {
+    /*
+        NOTE: glibc tells the writer of a lock by its thread ID, which 
+        is not the same in the child, so the lock is created anew.
+    */
+
+    (void) pthread_rwlock_init(&modules_lock, NULL);
+}
+
+/* ========================================================================> */
+
+void jm_filter_lock_blocks(void) {
+    pthread_mutex_lock(&blocks_mutex);
+}
+
+void jm_filter_unlock_blocks(void) {
+    pthread_mutex_unlock(&blocks_mutex);
+}
+
+/* ========================================================================> */
+
+bool jm_filter_accept(jmEvent *event, size_t *size) {
+    if (!is_enabled) return true;
+
+    if (event->opcode == JM_OPCODE_REALLOC
+        || event->opcode == JM_OPCODE_REMAP) {
+        /*
+            NOTE: The old block is known to the interpreter if it passed 
+            the size filters, and was not rejected by the other filters.
+        */
+
+        bool is_known = (event->old_ptr != NULL)
+                        && (event->old_size >= min_size)
+                        && (event->old_size <= max_size);
+
+        if (event->opcode == JM_OPCODE_REALLOC && event->old_ptr != NULL
+            && jm_filter_remove_block(event->old_ptr))
+            is_known = false;
+
+        /*
+            NOTE: A new block that passes the size filters is recorded 
+            (the interpreter can resize a block it does not know about),
+            and so is its free, since the two sizes are the same.
+        */
+
+        if (*size >= min_size && *size <= max_size) return true;
+
+        jm_filter_count(event, *size);
+
+        if (!is_known) return false;
+
+        // NOTE: Otherwise, the old block is simply released
+        *size = event->old_size;
+
+        if (event->opcode == JM_OPCODE_REALLOC) {
+            *event = (jmEvent) { .opcode = JM_OPCODE_FREE,
+                                 .kind = event->kind,
+                                 .ptr = event->old_ptr };
+        } else {
+            *event = (jmEvent) { .opcode = JM_OPCODE_UNMAP,
+                                 .kind = event->kind,
+                                 .ptr = event->old_ptr,
+                                 .size = event->old_size };
+        }
+
+        return true;
+    }
+
+    /*
+        NOTE: The usable size of a block is checked against the size 
+        filters (both when it is allocated and when it is freed), so 
+        that the two decisions always agree. The size passed to a sized
+        `operator delete` is the requested size, not the usable size.
+    */
+
+    if (event->opcode == JM_OPCODE_FREE && event->size > 0
+        && (min_size > 0 || max_size < SIZE_MAX))
+        *size = malloc_usable_size((void *) event->ptr);
+
+    bool result = (*size >= min_size) && (*size <= max_size);
+
+    /*
+        NOTE: A block can be freed by any thread from any module, so 
+        the caller and thread filters only apply to new allocations, and
+        the frees of the blocks they have rejected are rejected as well.
+    */
+
+    if (result
+        && (event->opcode == JM_OPCODE_ALLOC || event->opcode == JM_OPCODE_MAP))
+        result = jm_filter_accept_thread()
+                 && jm_filter_accept_caller(event->caller);
+
+    // NOTE: A block that cannot be remembered is recorded after all
+    if (!result && event->opcode == JM_OPCODE_ALLOC
+        && (*size >= min_size) && (*size <= max_size))
+        result = !jm_filter_add_block(event->ptr);
+
+    if (result && event->opcode == JM_OPCODE_FREE)
+        result = !jm_filter_remove_block(event->ptr);
+
+    if (!result) jm_filter_count(event, *size);
+
+    return result;
+}
+
+void jm_filter_set_dirty(void) {
+    __atomic_store_n(&is_dirty, true, __ATOMIC_RELAXED);
+}
+
+void jm_filter_set_names_dirty(void) {
+    __atomic_fetch_add(&name_generation, 1, __ATOMIC_RELAXED);
+}
+
+/* Private Functions ======================================================> */
+
+static void jm_filter_init_(void) {
+    pthread_key_create(&thread_key, NULL);
+
+    if (readlink("/proc/self/exe", exec_path, PATH_MAX) == -1)
+        exec_path[0] = '\0';
+
+    const char *value = NULL;
+
+    if ((value = getenv("JMPROF_MIN_SIZE")) != NULL)
+        min_size = strtoull(value, NULL, 10);
+
+    if ((value = getenv("JMPROF_MAX_SIZE")) != NULL)
+        max_size = strtoull(value, NULL, 10);
+
+    include_modules = getenv("JMPROF_INCLUDE");
+    exclude_modules = getenv("JMPROF_EXCLUDE");
+
+    include_threads = getenv("JMPROF_THREADS");
+    exclude_threads = getenv("JMPROF_EXCLUDE_THREADS");
+
+    is_enabled = (min_size > 0) || (max_size < SIZE_MAX)
+                 || (include_modules != NULL) || (exclude_modules != NULL)
+                 || (include_threads != NULL) || (exclude_threads != NULL);
+}
+
+static void jm_filter_deinit_(void) {
+    if (!is_enabled) return;
+
+    is_enabled = false;
+
+    // NOTE: The other threads might still be writing their events
+    jm_backtrace_lock();
+
+    // `<OPERATION> <ADDRESS> <ALLOCS> <BYTES> <FREES> <BYTES> <MAPS> <BYTES>`
+    jm_tracker_fprintf("%c 0x0 %ju %ju %ju %ju %ju %ju\n",
+                       JM_OPCODE_FILTERED,
+                       counters.alloc_count,
+                       counters.alloc_total,
+                       counters.free_count,
+                       counters.free_total,
+                       counters.map_count,
+                       counters.map_total);
+
+    jm_backtrace_unlock();
+
+    pthread_key_delete(thread_key);
+}
+
+/* ========================================================================> */
+
+static bool jm_filter_accept_caller(const void *caller) {
+    if (include_modules == NULL && exclude_modules == NULL) return true;
+
+    if (__atomic_load_n(&is_dirty, __ATOMIC_RELAXED))
+        jm_filter_update_modules();
+
+    // NOTE: A caller outside of any module (e.g. JIT-compiled code)
+    bool result = (include_modules == NULL);
+
+    pthread_rwlock_rdlock(&modules_lock);
+
+    {
+        for (size_t i = 0; i < modules.count; i++) {
+            if ((uintptr_t) caller < modules.buffer[i].start
+                || (uintptr_t) caller >= modules.buffer[i].end)
+                continue;
+
+            result = modules.buffer[i].is_accepted;
+
+            break;
+        }
+    }
+
+    pthread_rwlock_unlock(&modules_lock);
+
+    return result;
+}
+
+static bool jm_filter_accept_thread(void) {
+    if (include_threads == NULL && exclude_threads == NULL) return true;
+
+    uintptr_t value = (uintptr_t) pthread_getspecific(thread_key);
+
+    uintptr_t generation = __atomic_load_n(&name_generation, __ATOMIC_RELAXED);
+
+    /*
+        NOTE: The name of a thread is looked up only once (on its first 
+        allocation), since `prctl()` is a system call, and again after
+        any thread has been renamed.
+    */
+
+    if ((value >> 1) != generation) {
+        char name[MAX_THREAD_NAME_SIZE] = { '\0' };
+
+        (void) prctl(PR_GET_NAME, name, 0, 0, 0);
+
+        bool is_accepted = ((include_threads == NULL)
+                            || match_any(name, include_threads))
+                           && ((exclude_threads == NULL)
+                               || !match_any(name, exclude_threads));
+
+        value = (generation << 1) | is_accepted;
+
+        pthread_setspecific(thread_key, (void *) value);
+    }
+
+    return (value & 1);
+}
+
+static bool jm_filter_add_block(const void *ptr) {
+    bool result = false;
+
+    pthread_mutex_lock(&blocks_mutex);
+
+    // NOTE: The set is kept at most half full
+    if (blocks.count < MAX_FILTERED_COUNT / 2) {
+        size_t i = hash_pointer(ptr);
+
+        while (blocks.buffer[i] != NULL && blocks.buffer[i] != ptr)
+            i = (i + 1) & (MAX_FILTERED_COUNT - 1);
+
+        if (blocks.buffer[i] == NULL) blocks.count++;
+
+        blocks.buffer[i] = ptr, result = true;
+    }
+
+    pthread_mutex_unlock(&blocks_mutex);
+
+    return result;
+}
+
+static bool jm_filter_remove_block(const void *ptr) {
+    // NOTE: Most programs never reject anything but by size
+    if (__atomic_load_n(&blocks.count, __ATOMIC_RELAXED) == 0) return false;
+
+    bool result = false;
+
+    pthread_mutex_lock(&blocks_mutex);
+
+    {
+        size_t i = hash_pointer(ptr);
+
+        for (; blocks.buffer[i] != NULL; i = (i + 1) & (MAX_FILTERED_COUNT - 1))
+            if (blocks.buffer[i] == ptr) break;
+
+        if (blocks.buffer[i] != NULL) {
+            blocks.buffer[i] = NULL, blocks.count--;
+
+            /*
+                NOTE: Every entry after the removed one (in the same run)
+                is moved back if the empty slot is closer to its home.
+            */
+
+            for (size_t j = (i + 1) & (MAX_FILTERED_COUNT - 1);
+                 blocks.buffer[j] != NULL;
+                 j = (j + 1) & (MAX_FILTERED_COUNT - 1)) {
+                size_t home = hash_pointer(blocks.buffer[j]);
+
+                if (((j - home) & (MAX_FILTERED_COUNT - 1))
+                    < ((j - i) & (MAX_FILTERED_COUNT - 1)))
+                    continue;
+
+                blocks.buffer[i] = blocks.buffer[j], blocks.buffer[j] = NULL;
+
+                i = j;
+            }
+
+            result = true;
+        }
+    }
+
+    pthread_mutex_unlock(&blocks_mutex);
+
+    return result;
+}
+
+static void jm_filter_count(const jmEvent *event, size_t size) {
+    switch (event->opcode) {
+        case JM_OPCODE_ALLOC:
+        case JM_OPCODE_REALLOC:
+            __atomic_fetch_add(&counters.alloc_count, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&counters.alloc_total, size, __ATOMIC_RELAXED);
+
+            break;
+
+        case JM_OPCODE_FREE:
+            __atomic_fetch_add(&counters.free_count, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&counters.free_total, size, __ATOMIC_RELAXED);
+
+            break;
+
+        case JM_OPCODE_MAP:
+        case JM_OPCODE_REMAP:
+            __atomic_fetch_add(&counters.map_count, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&counters.map_total, size, __ATOMIC_RELAXED);
+
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void jm_filter_update_modules(void) {
+    pthread_rwlock_wrlock(&modules_lock);
+
+    {
+        if (is_dirty) {
+            modules.count = 0;
+
+            (void) dl_iterate_phdr(dl_iterate_phdr_callback, NULL);
+
+            __atomic_store_n(&is_dirty, false, __ATOMIC_RELAXED);
+        }
+    }
+
+    pthread_rwlock_unlock(&modules_lock);
+}
+
+/* ========================================================================> */
+
+static int
+dl_iterate_phdr_callback(struct dl_phdr_info *info, size_t size, void *data) {
+    if (modules.count >= MAX_MODULE_COUNT) return 1;
+
+    const char *dlpi_name = info->dlpi_name;
+
+    if (dlpi_name == NULL || !dlpi_name[0]) dlpi_name = exec_path;
+
+    jmModuleRange range = { .start = UINTPTR_MAX, .end = 0 };
+
+    // NOTE: The range of a module spans all of its loadable segments
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+
+        if (phdr->p_type != PT_LOAD) continue;
+
+        uintptr_t start = info->dlpi_addr + phdr->p_vaddr;
+        uintptr_t end = start + phdr->p_memsz;
+
+        if (range.start > start) range.start = start;
+        if (range.end < end) range.end = end;
+    }
+
+    if (range.start >= range.end) return 0;
+
+    range.is_accepted = ((include_modules == NULL)
+                         || match_any(dlpi_name, include_modules))
+                        && ((exclude_modules == NULL)
+                            || !match_any(dlpi_name, exclude_modules));
+
+    modules.buffer[modules.count++] = range;
+
+    return 0;
+}
+
+static size_t hash_pointer(const void *ptr) {
+    // NOTE: Fibonacci hashing, since the lowest bits are always zero
+    uint64_t hash = (uint64_t) (uintptr_t) ptr * 11400714819323198485ULL;
+
+    return (size_t) (hash >> (64 - __builtin_ctz(MAX_FILTERED_COUNT)));
+}
+
+static bool match_any(const char *name, const char *patterns) {
+    // NOTE: `patterns` is a comma-separated list of substrings to look for
+    while (*patterns != '\0') {
+        size_t len = strcspn(patterns, ",");
+
+        if (len > 0) {
+            const char *ptr = name;
+
+            for (; (ptr = strchr(ptr, patterns[0])) != NULL; ptr++)
+                if (strncmp(ptr, patterns, len) == 0) return true;
+        }
+
+        patterns += len;
+
+        if (*patterns == ',') patterns++;
+    }
+
+    return false;
+}
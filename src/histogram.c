@@ -0,0 +1,314 @@
+/*
+    Copyright (c) 2024 Jaedeok Kim <jdeokkim@protonmail.com>
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included 
+    in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+
+/* Includes ===============================================================> */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <malloc.h>
+
+#include "sokol_time.h"
+
+#include "jmprof.h"
+
+/* Typedefs ===============================================================> */
+
+typedef struct jmHistogramSlot_ {
+    struct jmHistogramBucket_ {
+        uint64_t alloc_count, alloc_total;
+        uint64_t free_count, free_total;
+    } buckets[MAX_SIZE_CLASS_COUNT];
+    uint64_t event_count;
+} __attribute__((aligned(64))) jmHistogramSlot;
+
+/* Constants ==============================================================> */
+
+/*
+    NOTE: Each thread checks the time once every `2^6` events, and once
+    more when it exits, so that a flush is never held back for long by
+    threads that allocate rarely.
+*/
+
+static const uint64_t flush_check_mask = 63;
+
+/* Private Variables ======================================================> */
+
+static pthread_once_t histogram_init_once = PTHREAD_ONCE_INIT;
+static pthread_once_t histogram_deinit_once = PTHREAD_ONCE_INIT;
+
+/* ========================================================================> */
+
+static pthread_mutex_t flush_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* ========================================================================> */
+
+static pthread_key_t slot_key;
+
+/* ========================================================================> */
+
+/*
+    NOTE: Each thread owns a slot (the last one is shared by all threads
+    that come after the others), so that the counters of two threads 
+    never share a cache line.
+*/
+
+static jmHistogramSlot slots[MAX_SLOT_COUNT];
+
+static size_t slot_count = 0;
+
+/* ========================================================================> */
+
+static bool is_enabled = false;
+
+static uint64_t flush_count = 0, flush_interval = 100000000ULL;
+static uint64_t last_flush = 0;
+
+/* Private Function Prototypes ============================================> */
+
+static void jm_histogram_init_(void);
+static void jm_histogram_deinit_(void);
+
+/* ========================================================================> */
+
+static jmHistogramSlot *jm_histogram_get_slot(void);
+static void jm_histogram_add(uint64_t *counter, uint64_t value, bool is_shared);
+static void jm_histogram_check_flush(void *value);
+static void jm_histogram_flush(void);
+
+/* ========================================================================> */
+
+static int find_size_class(size_t size);
+
+/* Public Functions =======================================================> */
+
+void jm_histogram_init(void) {
+    pthread_once(&histogram_init_once, jm_histogram_init_);
+}
+
+void jm_histogram_deinit(void) {
+    pthread_once(&histogram_deinit_once, jm_histogram_deinit_);
+}
+
+/* ========================================================================> */
+
+void jm_histogram_atfork_prepare(void) {
+    pthread_mutex_lock(&flush_mutex);
+}
+
+void jm_histogram_atfork_parent(void) {
+    pthread_mutex_unlock(&flush_mutex);
+}
+
+void jm_histogram_atfork_child(void) {
+    if (!is_enabled) return;
+
+    // NOTE: A child process starts counting from zero
+    (void) memset(slots, 0, sizeof slots);
+
+    flush_count = 0, last_flush = stm_now();
+}
+
+/* ========================================================================> */
+
+bool jm_histogram_is_enabled(void) {
+    return is_enabled;
+}
+
+void jm_histogram_count(jmEvent event) {
+    if (event.opcode == JM_OPCODE_FREE && event.ptr == NULL) return;
+
+    jmHistogramSlot *slot = jm_histogram_get_slot();
+
+    bool is_shared = (slot == &slots[MAX_SLOT_COUNT - 1]);
+
+    /*
+        NOTE: A reallocation is counted as an allocation of the new block
+        and a deallocation of the old block.
+
+        New blocks are counted by their requested size, but only the usable
+        size of a block is known when it is freed.
+    */
+
+    if (event.opcode == JM_OPCODE_ALLOC || event.opcode == JM_OPCODE_REALLOC) {
+        if (event.ptr != NULL) {
+            struct jmHistogramBucket_ *bucket =
+                &slot->buckets[find_size_class(event.size)];
+
+            jm_histogram_add(&bucket->alloc_count, 1, is_shared);
+            jm_histogram_add(&bucket->alloc_total, event.size, is_shared);
+        }
+    }
+
+    if (event.opcode == JM_OPCODE_FREE
+        || (event.opcode == JM_OPCODE_REALLOC && event.old_ptr != NULL)) {
+        size_t size = event.old_size;
+
+        // NOTE: The size passed to a sized `operator delete` is trusted
+        if (event.opcode == JM_OPCODE_FREE)
+            size = (event.size > 0) ? event.size
+                                    : malloc_usable_size((void *) event.ptr);
+
+        struct jmHistogramBucket_ *bucket =
+            &slot->buckets[find_size_class(size)];
+
+        jm_histogram_add(&bucket->free_count, 1, is_shared);
+        jm_histogram_add(&bucket->free_total, size, is_shared);
+    }
+
+    if ((++slot->event_count & flush_check_mask) != 0) return;
+
+    jm_histogram_check_flush(slot);
+}
+
+/* Private Functions ======================================================> */
+
+static void jm_histogram_init_(void) {
+    const char *mode = getenv("JMPROF_MODE");
+
+    if (mode == NULL || strcmp(mode, "histogram") != 0) return;
+
+    const char *interval = getenv("JMPROF_FLUSH_INTERVAL");
+
+    // NOTE: The flush interval is given in milliseconds
+    if (interval != NULL && strtoull(interval, NULL, 10) > 0)
+        flush_interval = strtoull(interval, NULL, 10) * 1000000ULL;
+
+    pthread_key_create(&slot_key, jm_histogram_check_flush);
+
+    last_flush = stm_now();
+
+    is_enabled = true;
+}
+
+static void jm_histogram_deinit_(void) {
+    if (!is_enabled) return;
+
+    is_enabled = false;
+
+    jm_histogram_flush();
+
+    pthread_key_delete(slot_key);
+}
+
+/* ========================================================================> */
+
+static jmHistogramSlot *jm_histogram_get_slot(void) {
+    jmHistogramSlot *slot = pthread_getspecific(slot_key);
+
+    if (slot != NULL) return slot;
+
+    size_t index = __atomic_fetch_add(&slot_count, 1, __ATOMIC_RELAXED);
+
+    if (index >= MAX_SLOT_COUNT) index = MAX_SLOT_COUNT - 1;
+
+    slot = &slots[index];
+
+    pthread_setspecific(slot_key, slot);
+
+    return slot;
+}
+
+static void jm_histogram_add(uint64_t *counter,
+                             uint64_t value,
+                             bool is_shared) {
+    /*
+        NOTE: Only the owner of a slot writes to it, so a relaxed store is
+        enough for a thread that flushes the counters to never read a torn
+        value (unless the slot is shared).
+    */
+
+    if (is_shared)
+        __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+    else
+        __atomic_store_n(counter,
+                         __atomic_load_n(counter, __ATOMIC_RELAXED) + value,
+                         __ATOMIC_RELAXED);
+}
+
+static void jm_histogram_check_flush(void *value) {
+    (void) value;
+
+    if (stm_now() - __atomic_load_n(&last_flush, __ATOMIC_RELAXED)
+        >= flush_interval)
+        jm_histogram_flush();
+}
+
+static void jm_histogram_flush(void) {
+    if (pthread_mutex_trylock(&flush_mutex) != 0) return;
+
+    {
+        __atomic_store_n(&last_flush, stm_now(), __ATOMIC_RELAXED);
+
+        flush_count++;
+
+        size_t count = __atomic_load_n(&slot_count, __ATOMIC_RELAXED);
+
+        if (count > MAX_SLOT_COUNT) count = MAX_SLOT_COUNT;
+
+        for (int i = 0; i < MAX_SIZE_CLASS_COUNT; i++) {
+            struct jmHistogramBucket_ total = { 0 };
+
+            for (size_t j = 0; j < count; j++) {
+                const struct jmHistogramBucket_ *bucket = &slots[j].buckets[i];
+
+                total.alloc_count += __atomic_load_n(&bucket->alloc_count,
+                                                     __ATOMIC_RELAXED);
+                total.alloc_total += __atomic_load_n(&bucket->alloc_total,
+                                                     __ATOMIC_RELAXED);
+                total.free_count += __atomic_load_n(&bucket->free_count,
+                                                    __ATOMIC_RELAXED);
+                total.free_total += __atomic_load_n(&bucket->free_total,
+                                                    __ATOMIC_RELAXED);
+            }
+
+            if (total.alloc_count == 0 && total.free_count == 0) continue;
+
+            /*
+                NOTE: The counters are cumulative, so the interpreter only 
+                needs the last flush to know the totals.
+            */
+
+            // `<OPERATION> <FLUSH> <CLASS> <ALLOCS> <BYTES> <FREES> <BYTES>`
+            jm_tracker_fprintf("%c 0x%jx %d %ju %ju %ju %ju\n",
+                               JM_OPCODE_HISTOGRAM,
+                               flush_count,
+                               i,
+                               total.alloc_count,
+                               total.alloc_total,
+                               total.free_count,
+                               total.free_total);
+        }
+    }
+
+    pthread_mutex_unlock(&flush_mutex);
+}
+
+/* ========================================================================> */
+
+static int find_size_class(size_t size) {
+    // NOTE: The smallest power of two that can hold `size` bytes
+    return (size > 1) ? 64 - __builtin_clzll(size - 1) : 0;
+}
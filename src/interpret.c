@@ -20,16 +20,27 @@
     DEALINGS IN THE SOFTWARE.
 */
 
+
 /* Includes ===============================================================> */
 
 #define _GNU_SOURCE
 
+#include <errno.h>
 #include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 #include <elfutils/libdwfl.h>
 
-#define HASH_DEBUG
 #include "uthash.h"
 
 #include "jmprof.h"
@@ -39,8 +50,10 @@
 typedef struct jmInst_ {
     char opcode, ctx[MAX_BUFFER_SIZE];
     uint64_t timestamp;
-    size_t alloc_size;
-    void *addr;
+    size_t alloc_size, req_size, old_size;
+    void *addr, *old_addr;
+    uint64_t duration;
+    int tid, kind;
 } jmInst;
 
 typedef struct jmBacktrace_ {
@@ -58,30 +71,226 @@ typedef struct jmBacktrace_ {
     } src;
 } jmBacktrace;
 
-typedef struct jmAllocEntry_ {
-    void *key;
-    bool is_leaking;
-    size_t alloc_size;
-    uint64_t timestamp;
+/*
+    NOTE: The time spent in each call to the allocator falls into one of
+    four buckets for each power of two (in ticks of the cycle counter),
+    so that any percentile is known within 25%.
+*/
+
+typedef struct jmLatency_ {
+    struct jmLatencyHistogram_ {
+        size_t buckets[MAX_LATENCY_COUNT];
+        size_t count;
+        uint64_t total, max;
+    } alloc, free;
+} jmLatency;
+
+typedef struct jmAllocSite_ {
+    struct jmAllocSiteKey_ {
+        void *addrs[MAX_BACKTRACE_COUNT];
+    } key;
     struct jmBacktraces_ {
         jmBacktrace buffer[MAX_BACKTRACE_COUNT];
         size_t count;
     } traces;
+    struct jmAllocSiteStats_ {
+        size_t alloc_count, free_count, temp_count, total, slack;
+        size_t live, live_count, at_peak;
+        size_t cross_free_count, cross_free_total;
+    } stats;
+    struct jmAllocSiteReallocs_ {
+        size_t count, move_count, copied;
+        size_t chain_count, final_total, final_max;
+    } reallocs;
+    size_t lifetimes[MAX_LIFETIME_COUNT];
+    struct jmAllocSiteMaps_ {
+        size_t count, unmap_count, remap_count;
+        size_t total, live, peak, growth;
+    } maps;
+    struct jmAllocSiteGrowth_ {
+        size_t epochs[MAX_SNAPSHOT_COUNT];
+        double rate;
+        bool is_monotonic;
+    } growth;
+    size_t mismatches[JM_ALLOC_KIND_COUNT];
+    struct jmAllocSiteSamples_ {
+        size_t count, weighted_count;
+        uint64_t weight_total;
+    } samples[MAX_COUNTER_COUNT];
+    struct jmAllocSitePlacement_ {
+        size_t count, remote_count;
+        struct jmAllocSiteNode_ {
+            size_t fault_count, access_count, remote_count, touch_count;
+        } nodes[MAX_NODE_COUNT];
+    } placement;
+    struct jmAllocSiteCold_ {
+        size_t current, last, peak, live;
+    } cold;
+    jmLatency latency;
+    int index, kind;
+    UT_hash_handle hh;
+} jmAllocSite;
+
+typedef struct jmAllocEntry_ {
+    void *key;
+    size_t alloc_size, req_size, index;
+    uint64_t timestamp, duration;
+    jmAllocSite *site;
+    int tid, kind;
+    struct jmAllocEntryRealloc_ {
+        jmAllocSite *site;
+        uint64_t timestamp;
+        size_t count, copied;
+        bool is_moved;
+    } realloc;
+    bool is_paused;
+    struct jmAllocEntry_ *left, *right;
+    int priority;
     UT_hash_handle hh;
 } jmAllocEntry;
 
+typedef struct jmMapping_ {
+    void *key;
+    size_t length, growth;
+    jmAllocSite *site;
+    UT_hash_handle hh;
+} jmMapping;
+
+typedef struct jmMark_ {
+    uint64_t timestamp;
+    char command[MAX_BUFFER_SIZE], label[MAX_BUFFER_SIZE];
+} jmMark;
+
+typedef struct jmSnapshot_ {
+    uint64_t timestamp;
+    size_t heap, mapped;
+    struct jmSnapshotSite_ {
+        jmAllocSite *site;
+        size_t live;
+    } sites[MAX_TOP_SITE_COUNT];
+} jmSnapshot;
+
+typedef struct jmThread_ {
+    int key;
+    char name[MAX_THREAD_NAME_SIZE];
+    size_t last_index;
+    struct jmThreadStats_ {
+        size_t alloc_count, alloc_total;
+        size_t free_count, free_total;
+        size_t cross_free_count, cross_free_total;
+    } stats;
+    jmLatency latency;
+    jmAllocSite *free_site;
+    bool is_exited;
+    UT_hash_handle hh;
+} jmThread;
+
+typedef struct jmThreadPair_ {
+    uint64_t key;
+    int alloc_tid, free_tid;
+    size_t count, total;
+    UT_hash_handle hh;
+} jmThreadPair;
+
 typedef struct jmSummary_ {
     char path[MAX_BUFFER_SIZE];
+    int pid, ppid;
+    uint64_t clock_base;
     struct jmAllocStats_ {
-        size_t alloc_count, free_count, total;
+        size_t alloc_count, free_count, temp_count, total, slack;
+        size_t realloc_count, move_count, copied;
+        size_t mismatch_count;
+        size_t cross_free_count, cross_free_total;
     } stats;
+    struct jmMapStats_ {
+        size_t map_count, unmap_count, remap_count;
+        size_t live, peak;
+    } maps;
+    struct jmFilterStats_ {
+        size_t alloc_count, alloc_total;
+        size_t free_count, free_total;
+        size_t map_count, map_total;
+    } filtered;
+    struct jmSizeClass_ {
+        size_t alloc_count, req_total, total;
+    } classes[MAX_SIZE_CLASS_COUNT];
+    struct jmHistogram_ {
+        struct jmHistogramBucket_ {
+            size_t alloc_count, alloc_total;
+            size_t free_count, free_total;
+        } buckets[MAX_SIZE_CLASS_COUNT];
+        void *flush;
+        size_t flush_count, alloc_count, last_alloc_count;
+        uint64_t timestamp, last_timestamp;
+        double max_rate;
+    } histogram;
+    struct jmPeak_ {
+        uint64_t timestamp;
+        size_t heap, mapped, recorded;
+        bool is_pending;
+    } peak;
+    struct jmSnapshots_ {
+        jmSnapshot buffer[MAX_SNAPSHOT_COUNT];
+        size_t count;
+        uint64_t interval, next_timestamp;
+    } snapshots;
     struct jmRegions_ {
         jmRegion buffer[MAX_REGION_COUNT];
         size_t count;
     } regions;
-    jmAllocEntry *entries;
+    struct jmMarks_ {
+        jmMark buffer[MAX_MARK_COUNT];
+        size_t count, dropped, paused_count, dump_count;
+        bool is_paused;
+    } marks;
+    struct jmSampleStats_ {
+        size_t heap_count, map_count, other_count;
+    } samples[MAX_COUNTER_COUNT];
+    struct jmPlacement_ {
+        size_t count, remote_count, unknown_count;
+    } placement;
+    struct jmCold_ {
+        size_t scan_count, skipped, current, last, peak;
+        bool is_scanning;
+    } cold;
+    struct jmTiming_ {
+        jmLatency latency;
+        uint64_t ticks, nanoseconds, overhead;
+        size_t event_count;
+        bool is_enabled;
+    } timing;
+    bool is_indexed;
+    jmAllocEntry *entries, *tree;
+    jmAllocSite *sites;
+    jmMapping *mappings;
+    jmThread *threads;
+    jmThreadPair *thread_pairs;
 } jmSummary;
 
+typedef struct jmStream_ {
+    int key;
+    Dwfl *dwfl;
+    jmSummary summary;
+    struct jmParser_ {
+        jmAllocEntry *alloc_ctx;
+        jmMapping *map_ctx;
+        jmMark dump_ctx;
+        struct jmAllocSiteKey_ alloc_key;
+        size_t alloc_key_count, sample_index;
+        uint64_t timestamp;
+    } parser;
+    char buffer[MAX_READ_SIZE + 1];
+    size_t length;
+    UT_hash_handle hh;
+} jmStream;
+
+typedef struct jmProcess_ {
+    char path[MAX_BUFFER_SIZE];
+    int pid, ppid;
+    size_t alloc_count, free_count, live_count;
+    size_t heap, mapped, peak;
+} jmProcess;
+
 /* Constants ==============================================================> */
 
 const Dwfl_Callbacks dwfl_callbacks = {
@@ -91,101 +300,357 @@ const Dwfl_Callbacks dwfl_callbacks = {
     .debuginfo_path = NULL
 };
 
+/* ========================================================================> */
+
+// NOTE: Upper bounds (in nanoseconds) of each allocation lifetime bucket
+const uint64_t lifetime_bounds[MAX_LIFETIME_COUNT] = {
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    60000000000ULL,
+    600000000000ULL,
+    3600000000000ULL,
+    UINT64_MAX
+};
+
+const char *lifetime_labels[MAX_LIFETIME_COUNT] = {
+    "<100ns", "<1us", "<10us", "<100us", "<1ms", "<10ms", "<100ms",
+    "<1s",    "<10s", "<1m",   "<10m",   "<1h",  ">=1h"
+};
+
+/* ========================================================================> */
+
+// NOTE: Initial interval (in nanoseconds) between two heap snapshots
+const uint64_t snapshot_interval = 1000000ULL;
+
+// NOTE: Minimum number of epochs a site must be alive in to be "growing"
+const size_t min_growth_epochs = 4;
+
+/* ========================================================================> */
+
+// NOTE: Time (in milliseconds) to wait for new producers once all are gone
+const int collector_linger = 1000;
+
+/* ========================================================================> */
+
+const char *alloc_kind_names[JM_ALLOC_KIND_COUNT] = {
+    [JM_ALLOC_KIND_MALLOC] = "malloc",
+    [JM_ALLOC_KIND_NEW] = "new",
+    [JM_ALLOC_KIND_NEW_ARRAY] = "new[]",
+    [JM_ALLOC_KIND_NEW_ALIGNED] = "new(align_val_t)",
+    [JM_ALLOC_KIND_NEW_ARRAY_ALIGNED] = "new[](align_val_t)"
+};
+
+const char *free_kind_names[JM_ALLOC_KIND_COUNT] = {
+    [JM_ALLOC_KIND_MALLOC] = "free",
+    [JM_ALLOC_KIND_NEW] = "delete",
+    [JM_ALLOC_KIND_NEW_ARRAY] = "delete[]",
+    [JM_ALLOC_KIND_NEW_ALIGNED] = "delete(align_val_t)",
+    [JM_ALLOC_KIND_NEW_ARRAY_ALIGNED] = "delete[](align_val_t)"
+};
+
 /* Private Variables ======================================================> */
 
 static Dwfl *dwfl;
 
 /* ========================================================================> */
 
-static jmSummary summary;
+static size_t page_size = 4096;
+
+/* ========================================================================> */
+
+static uint64_t epoch_interval = snapshot_interval;
+
+static double growth_threshold = 0.0;
+
+/* ========================================================================> */
+
+// NOTE: The summary and the parser state of the stream being decoded
+static jmSummary *summary;
+
+static struct jmParser_ *parser;
+
+/* ========================================================================> */
+
+static jmStream *streams;
+
+static struct jmProcesses_ {
+    jmProcess buffer[MAX_PROCESS_COUNT];
+    size_t count, dropped;
+} processes;
+
+static volatile sig_atomic_t is_interrupted = 0;
+
+/* ========================================================================> */
+
+static struct jmSampleLog_ {
+    jmSample *buffer;
+    size_t count, lost_count;
+    char names[MAX_COUNTER_COUNT][MAX_BUFFER_SIZE];
+    struct jmSampleTotals_ {
+        uint64_t value, time_enabled, time_running;
+    } totals[MAX_COUNTER_COUNT];
+    size_t counts[MAX_COUNTER_COUNT];
+    uint32_t counter_count;
+    int fault_counter, node_count;
+} sample_log;
+
+static int sample_counter;
 
 /* Private Function Prototypes ============================================> */
 
 static void jm_symbols_alloc_add_entry(jmInst inst);
 static jmAllocEntry *jm_symbols_alloc_find_entry(void *key);
 static void jm_symbols_alloc_delete_entry(jmAllocEntry *entry);
-static void jm_symbols_alloc_push_backtrace(jmAllocEntry *entry,
-                                            jmBacktrace bt);
+static void jm_symbols_alloc_commit_entry(jmAllocEntry *entry,
+                                          const struct jmAllocSiteKey_ *key,
+                                          size_t count);
+static void jm_symbols_alloc_free_entry(jmAllocEntry *entry, jmInst inst);
+static jmAllocEntry *jm_symbols_alloc_realloc_entry(jmInst inst);
+static void jm_symbols_alloc_end_chain(jmAllocEntry *entry);
+static void jm_symbols_alloc_check_kind(jmAllocEntry *entry, int kind);
+static void jm_symbols_alloc_pause(void);
+
+/* ========================================================================> */
+
+static void jm_symbols_tree_insert(jmAllocEntry *entry);
+static void jm_symbols_tree_remove(jmAllocEntry *entry);
+static jmAllocEntry *jm_symbols_tree_find(const void *addr);
+static void jm_symbols_tree_split(jmAllocEntry *root,
+                                  const void *key,
+                                  jmAllocEntry **lhs,
+                                  jmAllocEntry **rhs);
+static jmAllocEntry *jm_symbols_tree_merge(jmAllocEntry *lhs,
+                                           jmAllocEntry *rhs);
+
+/* ========================================================================> */
+
+static bool jm_symbols_sample_load(const char *path);
+static void jm_symbols_sample_attribute(uint64_t timestamp);
+static double jm_symbols_sample_get_scale(int counter);
+static double jm_symbols_sample_get_faults(const jmAllocSite *site);
+static void jm_symbols_sample_place(jmAllocSite *site, const jmSample *sample);
+static int jm_symbols_sample_compare(const void *lhs, const void *rhs);
+
+/* ========================================================================> */
+
+static void jm_symbols_latency_add(struct jmLatencyHistogram_ *histogram,
+                                   uint64_t ticks);
+static uint64_t jm_symbols_latency_get_percentile(
+    const struct jmLatencyHistogram_ *histogram,
+    double ratio);
+static double jm_symbols_latency_get_scale(void);
+
+/* ========================================================================> */
+
+static void jm_symbols_cold_begin_scan(void);
+static void jm_symbols_cold_end_scan(void);
+static void jm_symbols_cold_add(uintptr_t start, uintptr_t end);
+static void jm_symbols_cold_add_entries(jmAllocEntry *node,
+                                        uintptr_t start,
+                                        uintptr_t end);
+
+/* ========================================================================> */
+
+static jmMapping *jm_symbols_map_add(jmInst inst);
+static void jm_symbols_map_delete(jmMapping *mapping);
+static void jm_symbols_map_commit(jmMapping *mapping,
+                                  const struct jmAllocSiteKey_ *key,
+                                  size_t count);
+static void jm_symbols_map_release(void *addr, size_t length);
+static jmMapping *jm_symbols_map_remap(jmInst inst);
+
+/* ========================================================================> */
+
+static void jm_symbols_histogram_add(jmInst inst);
+static void jm_symbols_histogram_end_flush(void);
+
+/* ========================================================================> */
+
+static void jm_symbols_heap_update(uint64_t timestamp);
+static void jm_symbols_heap_record_peak(void);
+static void jm_symbols_heap_take_snapshot(uint64_t timestamp);
+static void jm_symbols_heap_find_growth(jmAllocSite *site);
+
+/* ========================================================================> */
+
+static jmAllocSite *jm_symbols_site_find_or_add(
+    const struct jmAllocSiteKey_ *key,
+    size_t count);
+static void jm_symbols_site_delete(jmAllocSite *site);
+static int jm_symbols_site_compare(const void *lhs, const void *rhs);
+static int jm_symbols_site_compare_peak(const void *lhs, const void *rhs);
+static int jm_symbols_site_compare_live(const void *lhs, const void *rhs);
+static int jm_symbols_site_compare_growth(const void *lhs, const void *rhs);
+static int jm_symbols_site_compare_samples(const void *lhs, const void *rhs);
+static int jm_symbols_site_compare_cold(const void *lhs, const void *rhs);
+static int jm_symbols_site_compare_remote(const void *lhs, const void *rhs);
+static int jm_symbols_site_compare_cross_frees(const void *lhs,
+                                               const void *rhs);
+static int jm_symbols_thread_compare(const void *lhs, const void *rhs);
+static int jm_symbols_thread_pair_compare(const void *lhs, const void *rhs);
+static int jm_symbols_site_compare_latency(const void *lhs, const void *rhs);
+static int jm_symbols_thread_compare_latency(const void *lhs, const void *rhs);
+
+/* ========================================================================> */
+
+static jmThread *jm_symbols_thread_find_or_add(int tid);
+static void jm_symbols_thread_delete(jmThread *thread);
+static void jm_symbols_thread_free_entry(const jmAllocEntry *entry, int tid);
+
+/* ========================================================================> */
+
+static jmStream *jm_symbols_stream_create(int fd);
+static void jm_symbols_stream_delete(jmStream *stream);
+static void jm_symbols_stream_select(jmStream *stream);
+static bool jm_symbols_stream_read(jmStream *stream);
+static void jm_symbols_stream_parse(jmStream *stream, bool is_closing);
+static void jm_symbols_stream_close(jmStream *stream, const char *trailer);
+
+/* ========================================================================> */
+
+static int jm_symbols_collect(const char *path, const char *trailer);
+static void jm_symbols_interrupt(int signum);
+static void jm_symbols_process_add(void);
 
 /* ========================================================================> */
 
 static jmBacktrace jm_symbols_build_backtrace(void *ptr);
 static jmInst jm_symbols_build_inst(const char *buffer);
+static void jm_symbols_parse_inst(const char *buffer);
+static void jm_symbols_parse_end(void);
 static void jm_symbols_parse_log(FILE *fp);
 
+/* ========================================================================> */
+
+static void jm_symbols_print_report(const char *trailer);
+static void jm_symbols_print_processes(void);
+static void jm_symbols_print_header(FILE *fp);
+static void jm_symbols_print_backtraces(FILE *fp,
+                                        const struct jmBacktraces_ *traces);
+static void jm_symbols_print_lifetimes(const jmAllocSite *site);
+static void jm_symbols_print_reallocs(const jmAllocSite *site);
+static void jm_symbols_print_mismatches(const jmAllocSite *site);
+static void jm_symbols_print_mappings(const jmAllocSite *site);
+static void jm_symbols_print_size_classes(void);
+static void jm_symbols_print_histogram(void);
+static void jm_symbols_print_marks(void);
+static void jm_symbols_print_growth(void);
+static void jm_symbols_print_samples(void);
+static void jm_symbols_print_sample_totals(
+    const struct jmSampleTotals_ *totals);
+static void jm_symbols_print_site_samples(const jmAllocSite *site);
+static void jm_symbols_print_faults(void);
+static void jm_symbols_print_cold(void);
+static void jm_symbols_print_placement(void);
+static void jm_symbols_print_threads(void);
+static void jm_symbols_print_cross_frees(void);
+static void jm_symbols_print_latency(void);
+static void jm_symbols_print_latency_histogram(
+    const char *name,
+    const struct jmLatencyHistogram_ *histogram);
+static void jm_symbols_dump_live(const jmMark *mark);
+static void jm_symbols_print_snapshots(void);
+static void jm_symbols_print_peak(void);
+
 /* Public Functions =======================================================> */
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "%s: usage: %s <path>\n", argv[0], argv[0]);
+    const char *socket_path = NULL, *sample_path = NULL;
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "e:g:p:s:")) != -1) {
+        switch (opt) {
+            case 'e':
+                // NOTE: The length of an epoch is given in milliseconds
+                epoch_interval = strtoull(optarg, NULL, 10) * 1000000ULL;
+
+                if (epoch_interval == 0) epoch_interval = snapshot_interval;
+
+                break;
+
+            case 'g':
+                // NOTE: The growth rate threshold is given in bytes/second
+                growth_threshold = strtod(optarg, NULL);
+
+                break;
+
+            case 'p':
+                sample_path = optarg;
+
+                break;
+
+            case 's':
+                socket_path = optarg;
+
+                break;
+
+            default:
+                optind = argc;
+
+                break;
+        }
+    }
+
+    if (socket_path == NULL && optind >= argc) {
+        fprintf(stderr,
+                "%s: usage: %s [-e <epoch-ms>] [-g <bytes-per-sec>] "
+                "[-p <samples>] (<path> | -s <socket>)\n",
+                argv[0],
+                argv[0]);
 
         return 1;
     }
 
-    FILE *fp = fopen(argv[1], "r");
+    page_size = sysconf(_SC_PAGESIZE);
 
-    if (fp == NULL) {
+    if (sample_path != NULL && !jm_symbols_sample_load(sample_path)) {
         fprintf(stderr,
-                "%s: error: unable to open file '%s'\n",
+                "%s: error: unable to read samples from '%s'\n",
                 argv[0],
-                argv[1]);
+                sample_path);
 
         return 1;
     }
 
-    jm_symbols_parse_log(fp);
-
-    if (argv[2] != NULL) printf("\n%s\n", argv[2]);
+    if (socket_path != NULL)
+        return jm_symbols_collect(socket_path, argv[optind]);
 
-    printf("\njmprof v" JMPROF_VERSION " by " JMPROF_AUTHOR "\n\n"
-           "> %s\n\n",
-           summary.path);
+    FILE *fp = fopen(argv[optind], "r");
 
-    printf("SUMMARY: \n"
-           "  %d allocs, %d frees (%ld bytes alloc-ed)\n\n",
-           summary.stats.alloc_count,
-           summary.stats.free_count,
-           summary.stats.total);
+    if (fp == NULL) {
+        fprintf(stderr,
+                "%s: error: unable to open file '%s'\n",
+                argv[0],
+                argv[optind]);
 
-    {
-        jmAllocEntry *head = summary.entries;
+        return 1;
+    }
 
-        for (int counter = 1; head != NULL; counter++, head = head->hh.next) {
-            if (!head->is_leaking) continue;
+    jmStream *stream = jm_symbols_stream_create(fileno(fp));
 
-            printf("  ~ alloc #%d (! %" PRIu64 " ms) -> [%ld bytes @ %p]: \n",
-                   counter,
-                   head->timestamp,
-                   head->alloc_size,
-                   head->key);
-
-            for (int i = 0; i < head->traces.count; i++) {
-                jmBacktrace bt = head->traces.buffer[i];
-
-                printf("    @ 0x%jx: %s (%s:%d:%d)\n"
-                       "      (in %s)\n",
-                       bt.addr,
-                       bt.sym.name,
-                       bt.src.name,
-                       bt.src.line,
-                       bt.src.column,
-                       bt.mod.name);
-            }
+    if (stream == NULL) {
+        fprintf(stderr, "%s: error: out of memory\n", argv[0]);
 
-            printf("\n");
-        }
+        fclose(fp);
 
-        /* clang-format off */
+        return 1;
+    }
 
-/* ========================================================================> */
+    jm_symbols_stream_select(stream);
 
-        jmAllocEntry *entry = NULL, *temp = NULL;
+    jm_symbols_parse_log(fp);
 
-        HASH_ITER(hh, summary.entries, entry, temp)
-            jm_symbols_alloc_delete_entry(entry);
+    jm_symbols_print_report(argv[optind + 1]);
 
-        /* clang-format on */
-    }
+    jm_symbols_stream_delete(stream);
 
     fclose(fp);
 
@@ -195,15 +660,42 @@ int main(int argc, char *argv[]) {
 /* Private Function Prototypes ============================================> */
 
 static void jm_symbols_alloc_add_entry(jmInst inst) {
+    /*
+        NOTE: An address that is still in use at this point must have been
+        released without us noticing (e.g. by an allocation function that 
+        we do not intercept), so the stale entry can be safely discarded.
+    */
+
+    jm_symbols_alloc_delete_entry(jm_symbols_alloc_find_entry(inst.addr));
+
     jmAllocEntry *entry = calloc(1, sizeof(jmAllocEntry));
 
     entry->key = inst.addr;
 
-    entry->is_leaking = true;
+    entry->index = summary->stats.alloc_count + summary->stats.realloc_count;
     entry->timestamp = inst.timestamp;
     entry->alloc_size = inst.alloc_size;
+    entry->req_size = inst.req_size;
+    entry->tid = inst.tid;
+    entry->kind = inst.kind;
+    entry->duration = inst.duration;
+
+    HASH_ADD_PTR(summary->entries, key, entry);
+
+    // NOTE: Blocks are only ordered by address when there are samples to join
+    if (summary->is_indexed) jm_symbols_tree_insert(entry);
+
+    jmThread *thread = jm_symbols_thread_find_or_add(inst.tid);
 
-    HASH_ADD_PTR(summary.entries, key, entry);
+    thread->last_index = entry->index;
+
+    thread->stats.alloc_count++;
+    thread->stats.alloc_total += entry->alloc_size;
+
+    if (summary->timing.is_enabled) {
+        jm_symbols_latency_add(&summary->timing.latency.alloc, inst.duration);
+        jm_symbols_latency_add(&thread->latency.alloc, inst.duration);
+    }
 }
 
 static jmAllocEntry *jm_symbols_alloc_find_entry(void *key) {
@@ -211,7 +703,7 @@ static jmAllocEntry *jm_symbols_alloc_find_entry(void *key) {
 
     jmAllocEntry *entry = NULL;
 
-    HASH_FIND_PTR(summary.entries, &key, entry);
+    HASH_FIND_PTR(summary->entries, &key, entry);
 
     return entry;
 }
@@ -219,169 +711,3159 @@ static jmAllocEntry *jm_symbols_alloc_find_entry(void *key) {
 static void jm_symbols_alloc_delete_entry(jmAllocEntry *entry) {
     if (entry == NULL) return;
 
-    HASH_DEL(summary.entries, entry);
+    HASH_DEL(summary->entries, entry);
+
+    if (summary->is_indexed) jm_symbols_tree_remove(entry);
 
     free(entry);
 }
 
-static void jm_symbols_alloc_push_backtrace(jmAllocEntry *entry,
-                                            jmBacktrace bt) {
-    entry->traces.buffer[entry->traces.count++] = bt;
+static void jm_symbols_alloc_commit_entry(jmAllocEntry *entry,
+                                          const struct jmAllocSiteKey_ *key,
+                                          size_t count) {
+    if (entry == NULL) return;
+
+    jmAllocSite *site = jm_symbols_site_find_or_add(key, count);
+
+    if (summary->timing.is_enabled)
+        jm_symbols_latency_add(&site->latency.alloc, entry->duration);
+
+    if (entry->realloc.count > 0) {
+        site->reallocs.count++;
+
+        if (entry->realloc.is_moved) {
+            site->reallocs.move_count++;
+            site->reallocs.copied += entry->realloc.copied;
+        }
+
+        entry->realloc.site = site;
+
+        // NOTE: A resized block still belongs to the site that allocated it
+        if (entry->site != NULL) return;
+    }
+
+    site->kind = entry->kind;
+
+    site->stats.alloc_count++;
+    site->stats.total += entry->alloc_size;
+    site->stats.live += entry->alloc_size;
+    site->stats.live_count++;
+    site->stats.slack += entry->alloc_size - entry->req_size;
+
+    entry->site = site;
 }
 
-/* ========================================================================> */
+static void jm_symbols_alloc_free_entry(jmAllocEntry *entry, jmInst inst) {
+    if (entry == NULL) return;
 
-static jmBacktrace jm_symbols_build_backtrace(void *ptr) {
-    jmBacktrace bt = { .addr = (GElf_Addr) ptr };
+    jm_symbols_alloc_check_kind(entry, inst.kind);
 
-    Dwfl_Module *mod = dwfl_addrmodule(dwfl, bt.addr);
+    summary->stats.total -= entry->alloc_size;
 
-    {
-        GElf_Addr mod_addr_start = 0, mod_addr_end = 0;
+    /*
+        NOTE: An allocation is "temporary" if it is freed by the same thread
+        before that thread makes any other allocation.
+    */
 
-        const char *mod_name = dwfl_module_info(
-            mod, NULL, &mod_addr_start, &mod_addr_end, NULL, NULL, NULL, NULL);
+    bool is_temporary = (entry->tid == inst.tid)
+                        && (jm_symbols_thread_find_or_add(inst.tid)->last_index
+                            == entry->index);
 
-        bt.mod.offset = mod_addr_start;
+    if (is_temporary) summary->stats.temp_count++;
 
-        if (mod_name == NULL) mod_name = "??";
+    jm_symbols_thread_free_entry(entry, inst.tid);
 
-        (void) strcpy(bt.mod.name, mod_name);
+    jmAllocSite *site = entry->site;
+
+    if (site != NULL) {
+        if (is_temporary) site->stats.temp_count++;
+
+        // NOTE: A resized block lives as long as its whole growth chain
+        uint64_t timestamp = (entry->realloc.count > 0)
+                                 ? entry->realloc.timestamp
+                                 : entry->timestamp;
+
+        uint64_t lifetime = (inst.timestamp > timestamp)
+                                ? inst.timestamp - timestamp
+                                : 0;
+
+        int i = 0;
+
+        while (lifetime >= lifetime_bounds[i]) i++;
+
+        site->lifetimes[i]++;
+
+        site->stats.free_count++;
+        site->stats.live -= entry->alloc_size;
+        site->stats.live_count--;
     }
 
-    {
-        GElf_Sym sym_info;
+    jm_symbols_alloc_end_chain(entry);
+    jm_symbols_alloc_delete_entry(entry);
+}
 
-        GElf_Addr sym_offset = 0;
+static jmAllocEntry *jm_symbols_alloc_realloc_entry(jmInst inst) {
+    // NOTE: `realloc(NULL, size)` is equivalent to `malloc(size)`
+    if (inst.old_addr == NULL) {
+        summary->stats.alloc_count++;
+        summary->stats.total += inst.alloc_size;
 
-        const char *sym_name = dwfl_module_addrinfo(
-            mod, bt.addr, &sym_offset, &sym_info, NULL, NULL, NULL);
+        jm_symbols_alloc_add_entry(inst);
 
-        if (sym_name == NULL) sym_name = "??";
+        return jm_symbols_alloc_find_entry(inst.addr);
+    }
 
-        (void) strcpy(bt.sym.name, sym_name);
+    summary->stats.realloc_count++;
+
+    jmAllocEntry *old_entry = jm_symbols_alloc_find_entry(inst.old_addr);
+
+    // NOTE: `realloc(ptr, 0)` frees `ptr` and returns a null pointer
+    if (inst.addr == NULL) {
+        summary->stats.free_count++;
+
+        jm_symbols_alloc_free_entry(old_entry, inst);
+
+        return NULL;
     }
 
-    {
-        Dwarf_Addr bias = 0;
+    size_t count = 0;
 
-        Dwarf_Die *die = dwfl_module_addrdie(mod, bt.addr, &bias);
+    uint64_t timestamp = inst.timestamp;
 
-        if (die != NULL) {
-            Dwarf_Line *src = dwarf_getsrc_die(die, bt.addr - bias);
+    jmAllocSite *site = NULL;
 
-            if (src != NULL) {
-                const char *src_name = dwarf_linesrc(src, NULL, NULL);
+    if (old_entry != NULL) {
+        jm_symbols_alloc_check_kind(old_entry, JM_ALLOC_KIND_MALLOC);
 
-                if (src_name == NULL) src_name = "??";
+        summary->stats.total -= old_entry->alloc_size;
 
-                (void) strcpy(bt.src.name, src_name);
-            }
+        /*
+            NOTE: The resized block is counted as the same allocation,
+            so only the live bytes of its site change.
+        */
 
-            (void) dwarf_lineno(src, &bt.src.line);
-            (void) dwarf_linecol(src, &bt.src.column);
+        site = old_entry->site;
+
+        if (site != NULL) {
+            site->stats.live -= old_entry->alloc_size;
+            site->stats.live += inst.alloc_size;
         }
-    }
 
-    return bt;
-}
+        count = old_entry->realloc.count;
 
-static jmInst jm_symbols_build_inst(const char *buffer) {
-    jmInst inst = { .opcode = JM_OPCODE_UNKNOWN };
+        timestamp = (count > 0) ? old_entry->realloc.timestamp
+                                : old_entry->timestamp;
 
-    (void) sscanf(buffer,
-                  "%" PRIu64 " %c %p %s",
-                  &inst.timestamp,
-                  &inst.opcode,
-                  &inst.addr,
-                  inst.ctx);
+        jm_symbols_alloc_delete_entry(old_entry);
+    }
 
-    if (inst.opcode == JM_OPCODE_ALLOC)
-        inst.alloc_size = (size_t) strtol(inst.ctx, NULL, 10);
+    summary->stats.total += inst.alloc_size;
 
-    inst.ctx[strcspn(inst.ctx, "\r\n")] = '\0';
+    jm_symbols_alloc_add_entry(inst);
 
-    return inst;
-}
+    jmAllocEntry *entry = jm_symbols_alloc_find_entry(inst.addr);
 
-static void jm_symbols_parse_log(FILE *fp) {
-    dwfl = dwfl_begin(&dwfl_callbacks);
+    entry->site = site;
 
-    char buffer[MAX_BUFFER_SIZE];
+    /*
+        NOTE: If the block could not be resized in place, `realloc()` 
+        copies the contents of the old block to a new one.
+    */
 
-    void *alloc_ctx = NULL;
+    entry->realloc.count = count + 1;
+    entry->realloc.timestamp = timestamp;
+    entry->realloc.is_moved = (inst.addr != inst.old_addr);
 
-    while (fgets(buffer, sizeof buffer, fp) != NULL) {
-        jmInst inst = jm_symbols_build_inst(buffer);
+    if (entry->realloc.is_moved) {
+        entry->realloc.copied = (inst.old_size < inst.req_size)
+                                    ? inst.old_size
+                                    : inst.req_size;
 
-        switch (inst.opcode) {
-            case JM_OPCODE_ALLOC:
-                summary.stats.alloc_count++;
-                summary.stats.total += inst.alloc_size;
+        summary->stats.move_count++;
+        summary->stats.copied += entry->realloc.copied;
+    }
 
-                alloc_ctx = inst.addr;
+    return entry;
+}
 
-                jm_symbols_alloc_add_entry(inst);
+static void jm_symbols_alloc_check_kind(jmAllocEntry *entry, int kind) {
+    // NOTE: e.g. a block allocated with `new[]` must be freed with `delete[]`
+    if (entry->kind == kind) return;
 
-                break;
+    summary->stats.mismatch_count++;
 
-            case JM_OPCODE_BACKTRACE:
-                assert(alloc_ctx != NULL);
+    if (entry->site != NULL) entry->site->mismatches[kind]++;
+}
 
-                jm_symbols_alloc_push_backtrace(jm_symbols_alloc_find_entry(
-                                                    alloc_ctx),
-                                                jm_symbols_build_backtrace(
-                                                    inst.addr));
+static void jm_symbols_alloc_pause(void) {
+    /*
+        NOTE: Blocks that are still alive when the recording is paused 
+        might be freed while we cannot see it, so they should not be 
+        reported as leaks later on.
+    */
 
-                break;
+    jmAllocEntry *head = summary->entries;
 
-            case JM_OPCODE_EXEC_PATH:
-                (void) strcpy(summary.path, inst.ctx);
+    for (; head != NULL; head = head->hh.next) {
+        if (head->is_paused) continue;
 
-                break;
+        head->is_paused = true;
 
-            case JM_OPCODE_FREE:
-                summary.stats.free_count++;
-                summary.stats.total -= inst.alloc_size;
+        summary->marks.paused_count++;
+    }
+}
 
-                alloc_ctx = inst.addr;
+static void jm_symbols_alloc_end_chain(jmAllocEntry *entry) {
+    if (entry == NULL || entry->realloc.site == NULL) return;
 
-                jm_symbols_alloc_find_entry(inst.addr)->is_leaking = false;
+    jmAllocSite *site = entry->realloc.site;
 
-                break;
+    site->reallocs.chain_count++;
+    site->reallocs.final_total += entry->alloc_size;
 
-            case JM_OPCODE_MODULE:
-                if (strncmp(inst.ctx, "linux-vdso.so", strlen("linux-vdso.so"))
-                    == 0)
-                    continue;
+    if (site->reallocs.final_max < entry->alloc_size)
+        site->reallocs.final_max = entry->alloc_size;
+}
+
+/* ========================================================================> */
 
-                dwfl_report_begin_add(dwfl);
+static void jm_symbols_tree_insert(jmAllocEntry *entry) {
+    jmAllocEntry *lhs = NULL, *rhs = NULL;
 
-                Dwfl_Module *mod = dwfl_report_elf(
-                    dwfl, inst.ctx, inst.ctx, -1, (GElf_Addr) inst.addr, false);
+    entry->left = NULL, entry->right = NULL;
 
-                (void) dwfl_report_end(dwfl, NULL, NULL);
+    // NOTE: A treap stays balanced (on average) with random priorities
+    entry->priority = rand();
 
-                break;
+    jm_symbols_tree_split(summary->tree, entry->key, &lhs, &rhs);
 
-            case JM_OPCODE_REGION:
-                summary.regions.buffer[summary.regions.count].start = inst.addr;
+    summary->tree = jm_symbols_tree_merge(jm_symbols_tree_merge(lhs, entry),
+                                          rhs);
+}
 
-                (void)
-                    sscanf(inst.ctx,
-                           "%p",
-                           &summary.regions.buffer[summary.regions.count].end);
+static void jm_symbols_tree_remove(jmAllocEntry *entry) {
+    jmAllocEntry *lhs = NULL, *mid = NULL, *rhs = NULL;
 
-                summary.regions.count++;
+    jm_symbols_tree_split(summary->tree, entry->key, &lhs, &rhs);
+    jm_symbols_tree_split(rhs, (const char *) entry->key + 1, &mid, &rhs);
 
-                break;
+    summary->tree = jm_symbols_tree_merge(lhs, rhs);
+}
 
-            default:
-                inst.opcode = JM_OPCODE_UNKNOWN;
+static jmAllocEntry *jm_symbols_tree_find(const void *addr) {
+    jmAllocEntry *node = summary->tree, *result = NULL;
 
-                break;
-        }
+    // NOTE: The block with the highest address not above `addr`
+    while (node != NULL) {
+        if ((uintptr_t) node->key <= (uintptr_t) addr)
+            result = node, node = node->right;
+        else
+            node = node->left;
     }
 
-    dwfl_end(dwfl);
-}
\ No newline at end of file
+    if (result == NULL
+        || (uintptr_t) addr >= (uintptr_t) result->key + result->alloc_size)
+        return NULL;
+
+    return result;
+}
+
+static void jm_symbols_tree_split(jmAllocEntry *root,
+                                  const void *key,
+                                  jmAllocEntry **lhs,
+                                  jmAllocEntry **rhs) {
+    if (root == NULL) {
+        *lhs = NULL, *rhs = NULL;
+
+        return;
+    }
+
+    if ((uintptr_t) root->key < (uintptr_t) key) {
+        jm_symbols_tree_split(root->right, key, &root->right, rhs);
+
+        *lhs = root;
+    } else {
+        jm_symbols_tree_split(root->left, key, lhs, &root->left);
+
+        *rhs = root;
+    }
+}
+
+static jmAllocEntry *jm_symbols_tree_merge(jmAllocEntry *lhs,
+                                           jmAllocEntry *rhs) {
+    if (lhs == NULL) return rhs;
+    if (rhs == NULL) return lhs;
+
+    if (lhs->priority > rhs->priority) {
+        lhs->right = jm_symbols_tree_merge(lhs->right, rhs);
+
+        return lhs;
+    } else {
+        rhs->left = jm_symbols_tree_merge(lhs, rhs->left);
+
+        return rhs;
+    }
+}
+
+/* ========================================================================> */
+
+static bool jm_symbols_sample_load(const char *path) {
+    FILE *fp = fopen(path, "rb");
+
+    if (fp == NULL) return false;
+
+    jmSampleHeader header;
+
+    if (fread(&header, sizeof header, 1, fp) != 1
+        || memcmp(header.magic, SAMPLE_FILE_MAGIC, sizeof header.magic) != 0
+        || header.version != SAMPLE_FILE_VERSION) {
+        fclose(fp);
+
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.counter_count; i++) {
+        char name[MAX_BUFFER_SIZE];
+
+        if (fread(name, sizeof name, 1, fp) != 1) {
+            fclose(fp);
+
+            return false;
+        }
+
+        name[MAX_BUFFER_SIZE - 1] = '\0';
+
+        if (i < MAX_COUNTER_COUNT) (void) strcpy(sample_log.names[i], name);
+    }
+
+    sample_log.counter_count = (header.counter_count < MAX_COUNTER_COUNT)
+                                   ? header.counter_count
+                                   : MAX_COUNTER_COUNT;
+
+    // NOTE: The data address of a page fault sample is the first touch
+    sample_log.fault_counter = -1;
+
+    for (int i = sample_log.counter_count - 1; i >= 0; i--)
+        if (strstr(sample_log.names[i], "faults") != NULL
+            || strstr(sample_log.names[i], "FAULTS") != NULL)
+            sample_log.fault_counter = i;
+
+    size_t capacity = 0;
+
+    jmSample sample;
+
+    while (fread(&sample, sizeof sample, 1, fp) == 1) {
+        if (sample.kind == JM_SAMPLE_KIND_LOST)
+            sample_log.lost_count += sample.weight;
+
+        if (sample.kind == JM_SAMPLE_KIND_TOTAL
+            && sample.counter < sample_log.counter_count) {
+            struct jmSampleTotals_ *totals = &sample_log.totals[sample.counter];
+
+            totals->value += sample.weight;
+            totals->time_enabled += sample.addr;
+            totals->time_running += sample.phys_addr;
+        }
+
+        if (sample.kind != JM_SAMPLE_KIND_SAMPLE
+            || sample.counter >= sample_log.counter_count)
+            continue;
+
+        if (sample_log.count == capacity) {
+            capacity = (capacity > 0) ? 2 * capacity : 4096;
+
+            jmSample *buffer = realloc(sample_log.buffer,
+                                       capacity * sizeof(jmSample));
+
+            if (buffer == NULL) break;
+
+            sample_log.buffer = buffer;
+        }
+
+        sample_log.buffer[sample_log.count++] = sample;
+
+        sample_log.counts[sample.counter]++;
+
+        // NOTE: The pages may all be on one node, but not the CPUs
+        int node = (sample.node > sample.cpu_node) ? sample.node
+                                                   : sample.cpu_node;
+
+        if (node < MAX_NODE_COUNT && sample_log.node_count < node + 1)
+            sample_log.node_count = node + 1;
+    }
+
+    fclose(fp);
+
+    // NOTE: Each counter has a ring buffer of its own
+    qsort(sample_log.buffer,
+          sample_log.count,
+          sizeof(jmSample),
+          jm_symbols_sample_compare);
+
+    return true;
+}
+
+static void jm_symbols_sample_attribute(uint64_t timestamp) {
+    if (parser->sample_index >= sample_log.count) return;
+
+    // NOTE: Streams written by older versions do not have a clock base
+    if (summary->clock_base == 0) return;
+
+    for (; parser->sample_index < sample_log.count; parser->sample_index++) {
+        const jmSample *sample = &sample_log.buffer[parser->sample_index];
+
+        // NOTE: Samples taken before the process started are ignored
+        if (sample->timestamp < summary->clock_base) continue;
+
+        if (sample->timestamp - summary->clock_base >= timestamp) break;
+
+        if (sample->pid != summary->pid) continue;
+
+        // NOTE: Samples of the clock events have no data address
+        if (sample->addr == 0) continue;
+
+        if (sample->node >= 0 && sample->node < MAX_NODE_COUNT) {
+            summary->placement.count++;
+
+            if (sample->cpu_node != sample->node)
+                summary->placement.remote_count++;
+        } else {
+            summary->placement.unknown_count++;
+        }
+
+        /*
+            NOTE: Every instruction before this sample has been applied,
+            so the live blocks are exactly those at the time of the sample.
+        */
+
+        struct jmSampleStats_ *stats = &summary->samples[sample->counter];
+
+        jmAllocSite *site = NULL;
+
+        jmAllocEntry *entry = jm_symbols_tree_find((const void *) sample->addr);
+
+        if (entry != NULL) {
+            stats->heap_count++;
+
+            site = entry->site;
+        } else {
+            jmMapping *head = summary->mappings;
+
+            for (; head != NULL; head = head->hh.next)
+                if (sample->addr >= (uintptr_t) head->key
+                    && sample->addr < (uintptr_t) head->key + head->length)
+                    break;
+
+            if (head != NULL)
+                stats->map_count++, site = head->site;
+            else
+                stats->other_count++;
+        }
+
+        if (site == NULL) continue;
+
+        struct jmAllocSiteSamples_ *samples = &site->samples[sample->counter];
+
+        samples->count++;
+
+        if (sample->weight > 0) {
+            samples->weighted_count++;
+            samples->weight_total += sample->weight;
+        }
+
+        jm_symbols_sample_place(site, sample);
+    }
+}
+
+static double jm_symbols_sample_get_scale(int counter) {
+    /*
+        NOTE: Each sample stands for a whole sampling period of events, 
+        which is given away by the value of the counter in the whole run.
+    */
+
+    if (sample_log.totals[counter].value > 0 && sample_log.counts[counter] > 0)
+        return (double) sample_log.totals[counter].value
+               / sample_log.counts[counter];
+
+    return 1.0;
+}
+
+static double jm_symbols_sample_get_faults(const jmAllocSite *site) {
+    int i = sample_log.fault_counter;
+
+    if (i < 0 || i >= sample_log.counter_count) return 0.0;
+
+    return jm_symbols_sample_get_scale(i) * site->samples[i].count;
+}
+
+static void jm_symbols_sample_place(jmAllocSite *site, const jmSample *sample) {
+    if (sample->node < 0 || sample->node >= MAX_NODE_COUNT) return;
+
+    struct jmAllocSitePlacement_ *placement = &site->placement;
+
+    struct jmAllocSiteNode_ *node = &placement->nodes[sample->node];
+
+    placement->count++;
+
+    /*
+        NOTE: A page is usually placed on the node of the CPU that touched
+        it first, so the CPU of a page fault tells where the block was 
+        first used (most often, by the thread that allocated it).
+    */
+
+    if (sample->counter == sample_log.fault_counter) {
+        node->fault_count++;
+
+        if (sample->cpu_node >= 0 && sample->cpu_node < MAX_NODE_COUNT)
+            placement->nodes[sample->cpu_node].touch_count++;
+    } else {
+        node->access_count++;
+    }
+
+    if (sample->cpu_node != sample->node)
+        placement->remote_count++, node->remote_count++;
+}
+
+static int jm_symbols_sample_compare(const void *lhs, const void *rhs) {
+    const jmSample *s1 = lhs, *s2 = rhs;
+
+    if (s1->timestamp == s2->timestamp) return 0;
+
+    return (s1->timestamp < s2->timestamp) ? -1 : 1;
+}
+
+/* ========================================================================> */
+
+static void jm_symbols_latency_add(struct jmLatencyHistogram_ *histogram,
+                                   uint64_t ticks) {
+    int i = (int) ticks;
+
+    // NOTE: `4 * log2(ticks)`, plus the two bits after the leading one
+    if (ticks >= 8) {
+        int exponent = 63 - __builtin_clzll(ticks);
+
+        i = 4 * (exponent - 1) + ((ticks >> (exponent - 2)) & 3);
+    }
+
+    histogram->buckets[i]++;
+
+    histogram->count++;
+    histogram->total += ticks;
+
+    if (histogram->max < ticks) histogram->max = ticks;
+}
+
+static uint64_t jm_symbols_latency_get_percentile(
+    const struct jmLatencyHistogram_ *histogram,
+    double ratio) {
+    size_t rank = (size_t) (ratio * histogram->count), count = 0;
+
+    for (int i = 0; i < MAX_LATENCY_COUNT; i++) {
+        count += histogram->buckets[i];
+
+        if (count < rank || count == 0) continue;
+
+        if (i < 8) return i;
+
+        // NOTE: The middle of the bucket
+        int exponent = (i / 4) + 1;
+
+        uint64_t lower = (uint64_t) (4 + (i & 3)) << (exponent - 2);
+
+        uint64_t result = lower + ((1ULL << (exponent - 2)) >> 1);
+
+        return (result < histogram->max) ? result : histogram->max;
+    }
+
+    return histogram->max;
+}
+
+static double jm_symbols_latency_get_scale(void) {
+    const struct jmTiming_ *timing = &summary->timing;
+
+    /*
+        NOTE: How long a tick lasts is measured by the program itself, 
+        once it exits. Without that, durations are reported in ticks.
+    */
+
+    if (timing->ticks == 0 || timing->nanoseconds == 0) return 0.0;
+
+    return (double) timing->nanoseconds / timing->ticks;
+}
+
+/* ========================================================================> */
+
+static void jm_symbols_cold_begin_scan(void) {
+    if (summary->cold.is_scanning) jm_symbols_cold_end_scan();
+
+    // NOTE: The blocks alive so far are ordered by address once and for all
+    if (!summary->is_indexed) {
+        jmAllocEntry *head = summary->entries;
+
+        for (; head != NULL; head = head->hh.next)
+            jm_symbols_tree_insert(head);
+
+        summary->is_indexed = true;
+    }
+
+    summary->cold.is_scanning = true;
+
+    summary->cold.scan_count++;
+
+    jmAllocSite *head = summary->sites;
+
+    // NOTE: The cold bytes of a site are compared to its live bytes as of now
+    for (; head != NULL; head = head->hh.next)
+        head->cold.live = head->stats.live + head->maps.live;
+}
+
+static void jm_symbols_cold_end_scan(void) {
+    if (!summary->cold.is_scanning) return;
+
+    summary->cold.is_scanning = false;
+
+    summary->cold.last = summary->cold.current;
+
+    if (summary->cold.peak < summary->cold.current)
+        summary->cold.peak = summary->cold.current;
+
+    summary->cold.current = 0;
+
+    jmAllocSite *head = summary->sites;
+
+    for (; head != NULL; head = head->hh.next) {
+        struct jmAllocSiteCold_ *cold = &head->cold;
+
+        cold->last = cold->current;
+
+        if (cold->peak < cold->current) cold->peak = cold->current;
+
+        cold->current = 0;
+    }
+}
+
+static void jm_symbols_cold_add(uintptr_t start, uintptr_t end) {
+    if (!summary->cold.is_scanning) return;
+
+    jm_symbols_cold_add_entries(summary->tree, start, end);
+
+    jmMapping *head = summary->mappings;
+
+    for (; head != NULL; head = head->hh.next) {
+        uintptr_t lo = (uintptr_t) head->key, hi = lo + head->length;
+
+        if (lo < start) lo = start;
+        if (hi > end) hi = end;
+
+        if (lo >= hi || head->site == NULL) continue;
+
+        head->site->cold.current += hi - lo;
+
+        summary->cold.current += hi - lo;
+    }
+}
+
+static void jm_symbols_cold_add_entries(jmAllocEntry *node,
+                                        uintptr_t start,
+                                        uintptr_t end) {
+    if (node == NULL) return;
+
+    uintptr_t lo = (uintptr_t) node->key, hi = lo + node->alloc_size;
+
+    /*
+        NOTE: Blocks never overlap, so the blocks to the left of a block
+        that starts before `start` cannot reach into the range (and vice
+        versa for the blocks to the right of a block that starts after
+        `end`).
+    */
+
+    if (lo > start) jm_symbols_cold_add_entries(node->left, start, end);
+    if (lo < end) jm_symbols_cold_add_entries(node->right, start, end);
+
+    if (lo < start) lo = start;
+    if (hi > end) hi = end;
+
+    if (lo >= hi || node->site == NULL) return;
+
+    node->site->cold.current += hi - lo;
+
+    summary->cold.current += hi - lo;
+}
+
+/* ========================================================================> */
+
+static jmMapping *jm_symbols_map_add(jmInst inst) {
+    // NOTE: The length of a mapping is always rounded up to the page size
+    size_t length = (inst.alloc_size + page_size - 1) & ~(page_size - 1);
+
+    // NOTE: e.g. `MAP_FIXED` silently replaces any existing mappings
+    jm_symbols_map_release(inst.addr, length);
+
+    jmMapping *mapping = calloc(1, sizeof(jmMapping));
+
+    mapping->key = inst.addr;
+    mapping->length = length;
+
+    HASH_ADD_PTR(summary->mappings, key, mapping);
+
+    summary->maps.live += length;
+
+    if (summary->maps.peak < summary->maps.live)
+        summary->maps.peak = summary->maps.live;
+
+    return mapping;
+}
+
+static void jm_symbols_map_delete(jmMapping *mapping) {
+    if (mapping == NULL) return;
+
+    HASH_DEL(summary->mappings, mapping);
+
+    free(mapping);
+}
+
+static void jm_symbols_map_commit(jmMapping *mapping,
+                                  const struct jmAllocSiteKey_ *key,
+                                  size_t count) {
+    if (mapping == NULL) return;
+
+    jmAllocSite *site = jm_symbols_site_find_or_add(key, count);
+
+    site->maps.count++;
+    site->maps.total += mapping->length;
+    site->maps.live += mapping->length;
+    site->maps.growth += mapping->growth;
+
+    if (mapping->growth > 0) site->maps.remap_count++;
+
+    if (site->maps.peak < site->maps.live) site->maps.peak = site->maps.live;
+
+    mapping->site = site;
+}
+
+static void jm_symbols_map_release(void *addr, size_t length) {
+    uintptr_t start = (uintptr_t) addr, end = start + length;
+
+    jmMapping *mapping = NULL, *temp = NULL;
+
+    /*
+        NOTE: Any part of a mapping can be unmapped, so a mapping can 
+        shrink from either side or be split into two mappings.
+    */
+
+    HASH_ITER(hh, summary->mappings, mapping, temp) {
+        uintptr_t m_start = (uintptr_t) mapping->key;
+        uintptr_t m_end = m_start + mapping->length;
+
+        if (m_end <= start || end <= m_start) continue;
+
+        uintptr_t o_start = (m_start > start) ? m_start : start;
+        uintptr_t o_end = (m_end < end) ? m_end : end;
+
+        summary->maps.live -= (o_end - o_start);
+
+        if (mapping->site != NULL) {
+            mapping->site->maps.unmap_count++;
+            mapping->site->maps.live -= (o_end - o_start);
+        }
+
+        if (o_end < m_end) {
+            jmMapping *tail = calloc(1, sizeof(jmMapping));
+
+            tail->key = (void *) o_end;
+            tail->length = m_end - o_end;
+            tail->site = mapping->site;
+
+            HASH_ADD_PTR(summary->mappings, key, tail);
+        }
+
+        if (o_start > m_start) {
+            mapping->length = o_start - m_start;
+        } else {
+            jm_symbols_map_delete(mapping);
+        }
+    }
+}
+
+static jmMapping *jm_symbols_map_remap(jmInst inst) {
+    size_t old_length = (inst.old_size + page_size - 1) & ~(page_size - 1);
+
+    jm_symbols_map_release(inst.old_addr, old_length);
+
+    jmMapping *mapping = jm_symbols_map_add(inst);
+
+    if (mapping->length > old_length)
+        mapping->growth = mapping->length - old_length;
+
+    return mapping;
+}
+
+/* ========================================================================> */
+
+static void jm_symbols_histogram_add(jmInst inst) {
+    // NOTE: The address of a histogram record is the number of its flush
+    if (inst.addr != summary->histogram.flush) {
+        jm_symbols_histogram_end_flush();
+
+        summary->histogram.flush = inst.addr;
+    }
+
+    struct jmHistogramBucket_ bucket = { 0 };
+
+    int i = -1;
+
+    // `[...] <SIZE_CLASS> <ALLOCS> <BYTES> <FREES> <BYTES>`
+    if (sscanf(inst.ctx,
+               "%d %zu %zu %zu %zu",
+               &i,
+               &bucket.alloc_count,
+               &bucket.alloc_total,
+               &bucket.free_count,
+               &bucket.free_total)
+            != 5
+        || i < 0 || i >= MAX_SIZE_CLASS_COUNT)
+        return;
+
+    // NOTE: The counters in each flush are cumulative
+    summary->histogram.buckets[i] = bucket;
+
+    summary->histogram.alloc_count += bucket.alloc_count;
+    summary->histogram.timestamp = inst.timestamp;
+}
+
+static void jm_symbols_histogram_end_flush(void) {
+    if (summary->histogram.flush == NULL) return;
+
+    summary->histogram.flush_count++;
+
+    /*
+        NOTE: The allocation rate between two flushes is the difference of
+        the total number of allocations in each flush.
+    */
+
+    if (summary->histogram.timestamp > summary->histogram.last_timestamp) {
+        double rate = (summary->histogram.alloc_count
+                       - summary->histogram.last_alloc_count)
+                      / ((summary->histogram.timestamp
+                          - summary->histogram.last_timestamp)
+                         / 1e9);
+
+        if (summary->histogram.max_rate < rate)
+            summary->histogram.max_rate = rate;
+    }
+
+    summary->histogram.last_alloc_count = summary->histogram.alloc_count;
+    summary->histogram.last_timestamp = summary->histogram.timestamp;
+
+    summary->histogram.alloc_count = 0;
+    summary->histogram.flush = NULL;
+}
+
+/* ========================================================================> */
+
+static void jm_symbols_heap_update(uint64_t timestamp) {
+    size_t heap = summary->stats.total, mapped = summary->maps.live;
+
+    if (heap + mapped <= summary->peak.heap + summary->peak.mapped) return;
+
+    summary->peak.timestamp = timestamp;
+
+    summary->peak.heap = heap, summary->peak.mapped = mapped;
+
+    summary->peak.is_pending = true;
+}
+
+static void jm_symbols_heap_record_peak(void) {
+    if (!summary->peak.is_pending) return;
+
+    size_t peak = summary->peak.heap + summary->peak.mapped;
+
+    /*
+        NOTE: Walking every site on each new peak would make a steadily 
+        growing heap quadratic, so (like Massif) the breakdown is only
+        refreshed when the peak has grown by more than 1% since.
+    */
+
+    if (peak - summary->peak.recorded <= summary->peak.recorded / 100) return;
+
+    jmAllocSite *head = summary->sites;
+
+    for (; head != NULL; head = head->hh.next)
+        head->stats.at_peak = head->stats.live + head->maps.live;
+
+    summary->peak.recorded = peak;
+
+    summary->peak.is_pending = false;
+}
+
+static void jm_symbols_heap_take_snapshot(uint64_t timestamp) {
+    /*
+        NOTE: Once the buffer is full, every other snapshot is discarded
+        and the interval between two snapshots is doubled, so that the
+        snapshots always cover the whole run evenly.
+    */
+
+    if (summary->snapshots.count >= MAX_SNAPSHOT_COUNT) {
+        for (int i = 0; i < MAX_SNAPSHOT_COUNT / 2; i++)
+            summary->snapshots.buffer[i] = summary->snapshots.buffer[2 * i + 1];
+
+        jmAllocSite *head = summary->sites;
+
+        for (; head != NULL; head = head->hh.next)
+            for (int i = 0; i < MAX_SNAPSHOT_COUNT / 2; i++)
+                head->growth.epochs[i] = head->growth.epochs[2 * i + 1];
+
+        summary->snapshots.count = MAX_SNAPSHOT_COUNT / 2;
+        summary->snapshots.interval *= 2;
+    }
+
+    size_t index = summary->snapshots.count++;
+
+    jmSnapshot *snapshot = &summary->snapshots.buffer[index];
+
+    *snapshot = (jmSnapshot) { .timestamp = timestamp,
+                               .heap = summary->stats.total,
+                               .mapped = summary->maps.live };
+
+    jmAllocSite *head = summary->sites;
+
+    for (; head != NULL; head = head->hh.next) {
+        size_t live = head->stats.live + head->maps.live;
+
+        // NOTE: Each snapshot also marks the end of an epoch
+        head->growth.epochs[index] = live;
+
+        if (live == 0) continue;
+
+        // NOTE: Keeps the top sites sorted by their live bytes (descending)
+        int i = MAX_TOP_SITE_COUNT;
+
+        while (i > 0 && snapshot->sites[i - 1].live < live) {
+            if (i < MAX_TOP_SITE_COUNT)
+                snapshot->sites[i] = snapshot->sites[i - 1];
+
+            i--;
+        }
+
+        if (i < MAX_TOP_SITE_COUNT)
+            snapshot->sites[i] = (struct jmSnapshotSite_) { .site = head,
+                                                            .live = live };
+    }
+
+    summary->snapshots.next_timestamp = timestamp + summary->snapshots.interval;
+}
+
+static void jm_symbols_heap_find_growth(jmAllocSite *site) {
+    size_t first = 0, count = summary->snapshots.count;
+
+    // NOTE: A site does not exist before its first allocation
+    while (first < count && site->growth.epochs[first] == 0) first++;
+
+    if (count - first < min_growth_epochs) return;
+
+    /*
+        NOTE: The growth rate of a site is the slope of the least-squares
+        line through its live bytes at the end of each epoch.
+    */
+
+    double mean_x = 0.0, mean_y = 0.0;
+
+    for (size_t i = first; i < count; i++) {
+        mean_x += summary->snapshots.buffer[i].timestamp / 1e9;
+        mean_y += site->growth.epochs[i];
+    }
+
+    mean_x /= (count - first), mean_y /= (count - first);
+
+    double s_xy = 0.0, s_xx = 0.0;
+
+    bool is_monotonic = true;
+
+    for (size_t i = first; i < count; i++) {
+        double dx = (summary->snapshots.buffer[i].timestamp / 1e9) - mean_x;
+
+        s_xy += dx * (site->growth.epochs[i] - mean_y);
+        s_xx += dx * dx;
+
+        if (i > first && site->growth.epochs[i] < site->growth.epochs[i - 1])
+            is_monotonic = false;
+    }
+
+    site->growth.rate = (s_xx > 0.0) ? s_xy / s_xx : 0.0;
+
+    site->growth.is_monotonic = is_monotonic
+                                && (site->growth.epochs[count - 1]
+                                    > site->growth.epochs[first]);
+}
+
+/* ========================================================================> */
+
+static jmAllocSite *jm_symbols_site_find_or_add(
+    const struct jmAllocSiteKey_ *key,
+    size_t count) {
+    jmAllocSite *site = NULL;
+
+    HASH_FIND(hh, summary->sites, key, sizeof *key, site);
+
+    if (site != NULL) return site;
+
+    site = calloc(1, sizeof(jmAllocSite));
+
+    site->key = *key;
+
+    // NOTE: A site keeps its number, so that dumps can refer to it as well
+    site->index = HASH_COUNT(summary->sites) + 1;
+
+    /*
+        NOTE: Every allocation made from the same call stack shares 
+        the same site, so symbol resolution only needs to be done once.
+    */
+
+    for (int i = 0; i < count; i++)
+        site->traces.buffer[site->traces.count++] = jm_symbols_build_backtrace(
+            key->addrs[i]);
+
+    HASH_ADD(hh, summary->sites, key, sizeof site->key, site);
+
+    return site;
+}
+
+static void jm_symbols_site_delete(jmAllocSite *site) {
+    if (site == NULL) return;
+
+    HASH_DEL(summary->sites, site);
+
+    free(site);
+}
+
+static int jm_symbols_site_compare(const void *lhs, const void *rhs) {
+    const jmAllocSite *s1 = lhs, *s2 = rhs;
+
+    size_t t1 = s1->stats.total + s1->maps.total;
+    size_t t2 = s2->stats.total + s2->maps.total;
+
+    if (t1 == t2) return 0;
+
+    return (t1 < t2) ? 1 : -1;
+}
+
+static int jm_symbols_site_compare_peak(const void *lhs, const void *rhs) {
+    const jmAllocSite *s1 = *(jmAllocSite *const *) lhs;
+    const jmAllocSite *s2 = *(jmAllocSite *const *) rhs;
+
+    if (s1->stats.at_peak == s2->stats.at_peak) return 0;
+
+    return (s1->stats.at_peak < s2->stats.at_peak) ? 1 : -1;
+}
+
+static int jm_symbols_site_compare_live(const void *lhs, const void *rhs) {
+    const jmAllocSite *s1 = *(jmAllocSite *const *) lhs;
+    const jmAllocSite *s2 = *(jmAllocSite *const *) rhs;
+
+    size_t l1 = s1->stats.live + s1->maps.live;
+    size_t l2 = s2->stats.live + s2->maps.live;
+
+    if (l1 == l2) return 0;
+
+    return (l1 < l2) ? 1 : -1;
+}
+
+static int jm_symbols_site_compare_growth(const void *lhs, const void *rhs) {
+    const jmAllocSite *s1 = *(jmAllocSite *const *) lhs;
+    const jmAllocSite *s2 = *(jmAllocSite *const *) rhs;
+
+    if (s1->growth.rate == s2->growth.rate) return 0;
+
+    return (s1->growth.rate < s2->growth.rate) ? 1 : -1;
+}
+
+/* ========================================================================> */
+
+static int jm_symbols_site_compare_samples(const void *lhs, const void *rhs) {
+    const jmAllocSite *s1 = *(jmAllocSite *const *) lhs;
+    const jmAllocSite *s2 = *(jmAllocSite *const *) rhs;
+
+    size_t c1 = s1->samples[sample_counter].count;
+    size_t c2 = s2->samples[sample_counter].count;
+
+    if (c1 == c2) return 0;
+
+    return (c1 < c2) ? 1 : -1;
+}
+
+static int jm_symbols_site_compare_cold(const void *lhs, const void *rhs) {
+    const jmAllocSite *s1 = *(jmAllocSite *const *) lhs;
+    const jmAllocSite *s2 = *(jmAllocSite *const *) rhs;
+
+    if (s1->cold.peak == s2->cold.peak) return 0;
+
+    return (s1->cold.peak < s2->cold.peak) ? 1 : -1;
+}
+
+static int jm_symbols_site_compare_remote(const void *lhs, const void *rhs) {
+    const jmAllocSite *s1 = *(jmAllocSite *const *) lhs;
+    const jmAllocSite *s2 = *(jmAllocSite *const *) rhs;
+
+    const struct jmAllocSitePlacement_ *p1 = &s1->placement;
+    const struct jmAllocSitePlacement_ *p2 = &s2->placement;
+
+    if (p1->remote_count == p2->remote_count) {
+        if (p1->count == p2->count) return 0;
+
+        return (p1->count < p2->count) ? 1 : -1;
+    }
+
+    return (p1->remote_count < p2->remote_count) ? 1 : -1;
+}
+
+static int jm_symbols_site_compare_cross_frees(const void *lhs,
+                                               const void *rhs) {
+    const jmAllocSite *s1 = *(jmAllocSite *const *) lhs;
+    const jmAllocSite *s2 = *(jmAllocSite *const *) rhs;
+
+    if (s1->stats.cross_free_count == s2->stats.cross_free_count) return 0;
+
+    return (s1->stats.cross_free_count < s2->stats.cross_free_count) ? 1 : -1;
+}
+
+static int jm_symbols_thread_compare(const void *lhs, const void *rhs) {
+    const jmThread *t1 = *(jmThread *const *) lhs;
+    const jmThread *t2 = *(jmThread *const *) rhs;
+
+    if (t1->stats.alloc_total == t2->stats.alloc_total) return 0;
+
+    return (t1->stats.alloc_total < t2->stats.alloc_total) ? 1 : -1;
+}
+
+static int jm_symbols_thread_pair_compare(const void *lhs, const void *rhs) {
+    const jmThreadPair *p1 = *(jmThreadPair *const *) lhs;
+    const jmThreadPair *p2 = *(jmThreadPair *const *) rhs;
+
+    if (p1->count == p2->count) return 0;
+
+    return (p1->count < p2->count) ? 1 : -1;
+}
+
+static int jm_symbols_site_compare_latency(const void *lhs, const void *rhs) {
+    const jmLatency *l1 = &(*(jmAllocSite *const *) lhs)->latency;
+    const jmLatency *l2 = &(*(jmAllocSite *const *) rhs)->latency;
+
+    uint64_t t1 = l1->alloc.total + l1->free.total;
+    uint64_t t2 = l2->alloc.total + l2->free.total;
+
+    if (t1 == t2) return 0;
+
+    return (t1 < t2) ? 1 : -1;
+}
+
+static int jm_symbols_thread_compare_latency(const void *lhs, const void *rhs) {
+    const jmLatency *l1 = &(*(jmThread *const *) lhs)->latency;
+    const jmLatency *l2 = &(*(jmThread *const *) rhs)->latency;
+
+    uint64_t t1 = l1->alloc.total + l1->free.total;
+    uint64_t t2 = l2->alloc.total + l2->free.total;
+
+    if (t1 == t2) return 0;
+
+    return (t1 < t2) ? 1 : -1;
+}
+
+/* ========================================================================> */
+
+static jmThread *jm_symbols_thread_find_or_add(int tid) {
+    jmThread *thread = NULL;
+
+    HASH_FIND_INT(summary->threads, &tid, thread);
+
+    if (thread != NULL) return thread;
+
+    thread = calloc(1, sizeof(jmThread));
+
+    thread->key = tid;
+
+    HASH_ADD_INT(summary->threads, key, thread);
+
+    return thread;
+}
+
+static void jm_symbols_thread_delete(jmThread *thread) {
+    if (thread == NULL) return;
+
+    HASH_DEL(summary->threads, thread);
+
+    free(thread);
+}
+
+static void jm_symbols_thread_free_entry(const jmAllocEntry *entry, int tid) {
+    jmThread *thread = jm_symbols_thread_find_or_add(tid);
+
+    thread->stats.free_count++;
+    thread->stats.free_total += entry->alloc_size;
+
+    // NOTE: The time spent in `free()` is written right after this event
+    thread->free_site = entry->site;
+
+    if (entry->tid == tid) return;
+
+    /*
+        NOTE: A block that is freed by another thread than the one that
+        allocated it (e.g. a message passed from a producer to a consumer)
+        is usually handed back to the allocator through a lock, and its 
+        cache lines move from one core to another.
+    */
+
+    thread->stats.cross_free_count++;
+    thread->stats.cross_free_total += entry->alloc_size;
+
+    summary->stats.cross_free_count++;
+    summary->stats.cross_free_total += entry->alloc_size;
+
+    if (entry->site != NULL) {
+        entry->site->stats.cross_free_count++;
+        entry->site->stats.cross_free_total += entry->alloc_size;
+    }
+
+    uint64_t key = ((uint64_t) (uint32_t) entry->tid << 32) | (uint32_t) tid;
+
+    jmThreadPair *pair = NULL;
+
+    HASH_FIND(hh, summary->thread_pairs, &key, sizeof(uint64_t), pair);
+
+    if (pair == NULL) {
+        pair = calloc(1, sizeof(jmThreadPair));
+
+        pair->key = key;
+        pair->alloc_tid = entry->tid, pair->free_tid = tid;
+
+        HASH_ADD(hh, summary->thread_pairs, key, sizeof(uint64_t), pair);
+    }
+
+    pair->count++;
+    pair->total += entry->alloc_size;
+}
+
+/* ========================================================================> */
+
+static jmStream *jm_symbols_stream_create(int fd) {
+    jmStream *stream = calloc(1, sizeof(jmStream));
+
+    if (stream == NULL) return NULL;
+
+    stream->key = fd;
+
+    // NOTE: Each process has an address space (and modules) of its own
+    stream->dwfl = dwfl_begin(&dwfl_callbacks);
+
+    stream->summary.snapshots.interval = epoch_interval;
+
+    // NOTE: The blocks are only ordered by address if they are looked up
+    stream->summary.is_indexed = (sample_log.count > 0);
+
+    return stream;
+}
+
+static void jm_symbols_stream_delete(jmStream *stream) {
+    if (stream == NULL) return;
+
+    jm_symbols_stream_select(stream);
+
+    {
+        /* clang-format off */
+
+/* ========================================================================> */
+
+        jmAllocEntry *entry = NULL, *temp = NULL;
+
+        HASH_ITER(hh, summary->entries, entry, temp)
+            jm_symbols_alloc_delete_entry(entry);
+
+        jmAllocSite *site = NULL, *site_temp = NULL;
+
+        HASH_ITER(hh, summary->sites, site, site_temp)
+            jm_symbols_site_delete(site);
+
+        jmMapping *mapping = NULL, *mapping_temp = NULL;
+
+        HASH_ITER(hh, summary->mappings, mapping, mapping_temp)
+            jm_symbols_map_delete(mapping);
+
+        jmThread *thread = NULL, *thread_temp = NULL;
+
+        HASH_ITER(hh, summary->threads, thread, thread_temp)
+            jm_symbols_thread_delete(thread);
+
+        jmThreadPair *pair = NULL, *pair_temp = NULL;
+
+        HASH_ITER(hh, summary->thread_pairs, pair, pair_temp) {
+            HASH_DEL(summary->thread_pairs, pair);
+
+            free(pair);
+        }
+
+        /* clang-format on */
+    }
+
+    dwfl_end(stream->dwfl);
+
+    free(stream);
+}
+
+static void jm_symbols_stream_select(jmStream *stream) {
+    summary = &stream->summary, parser = &stream->parser;
+
+    dwfl = stream->dwfl;
+}
+
+static bool jm_symbols_stream_read(jmStream *stream) {
+    ssize_t result = read(stream->key,
+                          stream->buffer + stream->length,
+                          MAX_READ_SIZE - stream->length);
+
+    if (result < 0) return (errno == EINTR || errno == EAGAIN);
+
+    if (result == 0) return false;
+
+    stream->length += result;
+
+    jm_symbols_stream_select(stream);
+    jm_symbols_stream_parse(stream, false);
+
+    return true;
+}
+
+static void jm_symbols_stream_parse(jmStream *stream, bool is_closing) {
+    char *line = stream->buffer, *end = stream->buffer + stream->length;
+
+    *end = '\0';
+
+    while (line < end) {
+        char *next = memchr(line, '\n', end - line);
+
+        if (next == NULL) {
+            /*
+                NOTE: An incomplete line is kept until the next read, 
+                unless the stream has ended or the line fills the buffer.
+            */
+
+            if (!is_closing && end - line < MAX_READ_SIZE) break;
+
+            next = end;
+        }
+
+        *next = '\0';
+
+        // NOTE: An instruction is never longer than what `fgets()` reads
+        if (next - line >= MAX_BUFFER_SIZE) line[MAX_BUFFER_SIZE - 1] = '\0';
+
+        jm_symbols_parse_inst(line);
+
+        line = (next < end) ? next + 1 : end;
+    }
+
+    stream->length = end - line;
+
+    (void) memmove(stream->buffer, line, stream->length);
+}
+
+static void jm_symbols_stream_close(jmStream *stream, const char *trailer) {
+    jm_symbols_stream_select(stream);
+    jm_symbols_stream_parse(stream, true);
+
+    jm_symbols_parse_end();
+
+    jm_symbols_print_report(trailer);
+
+    jm_symbols_process_add();
+
+    HASH_DEL(streams, stream);
+
+    (void) close(stream->key);
+
+    jm_symbols_stream_delete(stream);
+}
+
+/* ========================================================================> */
+
+static int jm_symbols_collect(const char *path, const char *trailer) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+    if (strlen(path) >= sizeof addr.sun_path) {
+        fprintf(stderr,
+                "%s: error: socket path '%s' is too long\n",
+                program_invocation_name,
+                path);
+
+        return 1;
+    }
+
+    (void) strcpy(addr.sun_path, path);
+
+    // NOTE: A socket left behind by a previous collector is replaced
+    (void) unlink(path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (listen_fd < 0
+        || bind(listen_fd, (struct sockaddr *) &addr, sizeof addr) < 0
+        || listen(listen_fd, SOMAXCONN) < 0) {
+        fprintf(stderr,
+                "%s: error: unable to listen on '%s'\n",
+                program_invocation_name,
+                path);
+
+        if (listen_fd >= 0) (void) close(listen_fd);
+
+        return 1;
+    }
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    {
+        struct epoll_event event = { .events = EPOLLIN,
+                                     .data.fd = listen_fd };
+
+        (void) epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    }
+
+    {
+        // NOTE: No `SA_RESTART`, so that `epoll_wait()` is interrupted
+        struct sigaction action = { .sa_handler = jm_symbols_interrupt };
+
+        (void) sigaction(SIGINT, &action, NULL);
+        (void) sigaction(SIGTERM, &action, NULL);
+    }
+
+    size_t accept_count = 0;
+
+    while (!is_interrupted) {
+        struct epoll_event events[MAX_EVENT_COUNT];
+
+        /*
+            NOTE: Once every producer is gone, the collector waits a little 
+            longer for processes that have not connected yet.
+        */
+
+        int timeout = (accept_count > 0 && streams == NULL) ? collector_linger
+                                                            : -1;
+
+        int count = epoll_wait(epoll_fd, events, MAX_EVENT_COUNT, timeout);
+
+        if (count == 0) break;
+
+        if (count < 0) {
+            if (errno == EINTR) continue;
+
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == listen_fd) {
+                int stream_fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+
+                if (stream_fd < 0) continue;
+
+                jmStream *stream = jm_symbols_stream_create(stream_fd);
+
+                if (stream == NULL) {
+                    (void) close(stream_fd);
+
+                    continue;
+                }
+
+                HASH_ADD_INT(streams, key, stream);
+
+                struct epoll_event event = { .events = EPOLLIN,
+                                             .data.fd = stream_fd };
+
+                (void) epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stream_fd, &event);
+
+                accept_count++;
+            } else {
+                jmStream *stream = NULL;
+
+                HASH_FIND_INT(streams, &fd, stream);
+
+                if (stream != NULL && !jm_symbols_stream_read(stream))
+                    jm_symbols_stream_close(stream, trailer);
+            }
+        }
+    }
+
+    {
+        // NOTE: Streams that are still open end with the collector
+
+        jmStream *stream = NULL, *temp = NULL;
+
+        HASH_ITER(hh, streams, stream, temp)
+            jm_symbols_stream_close(stream, trailer);
+    }
+
+    jm_symbols_print_processes();
+
+    (void) close(epoll_fd);
+    (void) close(listen_fd);
+
+    (void) unlink(path);
+
+    return 0;
+}
+
+static void jm_symbols_interrupt(int signum) {
+    (void) signum;
+
+    is_interrupted = 1;
+}
+
+static void jm_symbols_process_add(void) {
+    if (processes.count >= MAX_PROCESS_COUNT) {
+        processes.dropped++;
+
+        return;
+    }
+
+    jmProcess *process = &processes.buffer[processes.count++];
+
+    (void) strcpy(process->path, summary->path);
+
+    process->pid = summary->pid, process->ppid = summary->ppid;
+
+    process->alloc_count = summary->stats.alloc_count;
+    process->free_count = summary->stats.free_count;
+    process->live_count = HASH_COUNT(summary->entries);
+
+    process->heap = summary->stats.total, process->mapped = summary->maps.live;
+    process->peak = summary->peak.heap + summary->peak.mapped;
+}
+
+/* ========================================================================> */
+
+static jmBacktrace jm_symbols_build_backtrace(void *ptr) {
+    jmBacktrace bt = { .addr = (GElf_Addr) ptr };
+
+    Dwfl_Module *mod = dwfl_addrmodule(dwfl, bt.addr);
+
+    {
+        GElf_Addr mod_addr_start = 0, mod_addr_end = 0;
+
+        const char *mod_name = dwfl_module_info(
+            mod, NULL, &mod_addr_start, &mod_addr_end, NULL, NULL, NULL, NULL);
+
+        bt.mod.offset = mod_addr_start;
+
+        if (mod_name == NULL) mod_name = "??";
+
+        (void) strcpy(bt.mod.name, mod_name);
+    }
+
+    {
+        GElf_Sym sym_info;
+
+        GElf_Addr sym_offset = 0;
+
+        const char *sym_name = dwfl_module_addrinfo(
+            mod, bt.addr, &sym_offset, &sym_info, NULL, NULL, NULL);
+
+        if (sym_name == NULL) sym_name = "??";
+
+        (void) strcpy(bt.sym.name, sym_name);
+    }
+
+    {
+        Dwarf_Addr bias = 0;
+
+        Dwarf_Die *die = dwfl_module_addrdie(mod, bt.addr, &bias);
+
+        if (die != NULL) {
+            Dwarf_Line *src = dwarf_getsrc_die(die, bt.addr - bias);
+
+            if (src != NULL) {
+                const char *src_name = dwarf_linesrc(src, NULL, NULL);
+
+                if (src_name == NULL) src_name = "??";
+
+                (void) strcpy(bt.src.name, src_name);
+            }
+
+            (void) dwarf_lineno(src, &bt.src.line);
+            (void) dwarf_linecol(src, &bt.src.column);
+        }
+    }
+
+    return bt;
+}
+
+static jmInst jm_symbols_build_inst(const char *buffer) {
+    jmInst inst = { .opcode = JM_OPCODE_UNKNOWN };
+
+    (void) sscanf(buffer,
+                  "%" PRIu64 " %c %p %[^\n]",
+                  &inst.timestamp,
+                  &inst.opcode,
+                  &inst.addr,
+                  inst.ctx);
+
+    // `<TIMESTAMP> <OPERATION> <ADDRESS> <SIZE> <REQUESTED_SIZE> <TID> <KIND>`
+    if (inst.opcode == JM_OPCODE_ALLOC || inst.opcode == JM_OPCODE_FREE
+        || inst.opcode == JM_OPCODE_MAP || inst.opcode == JM_OPCODE_UNMAP)
+        (void) sscanf(inst.ctx,
+                      "%zu %zu %d %d %" SCNu64,
+                      &inst.alloc_size,
+                      &inst.req_size,
+                      &inst.tid,
+                      &inst.kind,
+                      &inst.duration);
+
+    // `<TIMESTAMP> <OPERATION> <ADDRESS> <TID> [...]`
+    if (inst.opcode == JM_OPCODE_THREAD || inst.opcode == JM_OPCODE_THREAD_EXIT)
+        (void) sscanf(inst.ctx, "%d", &inst.tid);
+
+    // `<TIMESTAMP> <OPERATION> <ADDRESS> <TID> <DURATION>`
+    if (inst.opcode == JM_OPCODE_FREE_TIME)
+        (void) sscanf(inst.ctx, "%d %" SCNu64, &inst.tid, &inst.duration);
+
+    // `[...] <OLD_ADDRESS> <OLD_USABLE_SIZE>`
+    if (inst.opcode == JM_OPCODE_REALLOC || inst.opcode == JM_OPCODE_REMAP)
+        (void) sscanf(inst.ctx,
+                      "%zu %zu %d %d %p %zu %" SCNu64,
+                      &inst.alloc_size,
+                      &inst.req_size,
+                      &inst.tid,
+                      &inst.kind,
+                      &inst.old_addr,
+                      &inst.old_size,
+                      &inst.duration);
+
+    if (inst.kind < 0 || inst.kind >= JM_ALLOC_KIND_COUNT)
+        inst.kind = JM_ALLOC_KIND_MALLOC;
+
+    // NOTE: `malloc_usable_size()` never returns less than what was requested
+    if (inst.req_size > inst.alloc_size) inst.req_size = inst.alloc_size;
+
+    inst.ctx[strcspn(inst.ctx, "\r\n")] = '\0';
+
+    return inst;
+}
+
+static void jm_symbols_parse_inst(const char *buffer) {
+    jmInst inst = jm_symbols_build_inst(buffer);
+
+    /*
+        NOTE: The backtrace of an allocation is complete once 
+        we encounter an instruction with a different opcode.
+    */
+
+    /*
+        NOTE: A mark can be written by a signal handler at any time,
+        even between an allocation and its backtrace.
+    */
+
+    if (inst.opcode != JM_OPCODE_BACKTRACE && inst.opcode != JM_OPCODE_MARK) {
+        if (parser->alloc_ctx != NULL)
+            jm_symbols_alloc_commit_entry(parser->alloc_ctx,
+                                          &parser->alloc_key,
+                                          parser->alloc_key_count);
+
+        if (parser->map_ctx != NULL)
+            jm_symbols_map_commit(parser->map_ctx,
+                                  &parser->alloc_key,
+                                  parser->alloc_key_count);
+
+        parser->alloc_ctx = NULL, parser->map_ctx = NULL;
+
+        parser->alloc_key = (struct jmAllocSiteKey_) { .addrs = { NULL } };
+        parser->alloc_key_count = 0;
+
+        if (parser->dump_ctx.timestamp > 0) {
+            jm_symbols_dump_live(&parser->dump_ctx);
+
+            parser->dump_ctx.timestamp = 0;
+        }
+
+        /*
+            NOTE: Every allocation before this instruction now belongs 
+            to a site, so this is where the heap is actually "seen".
+        */
+
+        if (inst.opcode == JM_OPCODE_FREE
+            || inst.opcode == JM_OPCODE_REALLOC
+            || inst.opcode == JM_OPCODE_UNMAP
+            || inst.opcode == JM_OPCODE_REMAP)
+            jm_symbols_heap_record_peak();
+
+        if (inst.timestamp >= summary->snapshots.next_timestamp)
+            jm_symbols_heap_take_snapshot(inst.timestamp);
+
+        jm_symbols_sample_attribute(inst.timestamp);
+    }
+
+    switch (inst.opcode) {
+        case JM_OPCODE_ALLOC:
+            summary->stats.alloc_count++;
+            summary->stats.total += inst.alloc_size;
+            summary->stats.slack += inst.alloc_size - inst.req_size;
+
+            {
+                /*
+                    NOTE: The size class of a block is the smallest 
+                    power of two that can hold the requested size.
+                */
+
+                int i = (inst.req_size > 1)
+                            ? 64 - __builtin_clzll(inst.req_size - 1)
+                            : 0;
+
+                summary->classes[i].alloc_count++;
+                summary->classes[i].req_total += inst.req_size;
+                summary->classes[i].total += inst.alloc_size;
+            }
+
+            jm_symbols_alloc_add_entry(inst);
+
+            parser->alloc_ctx = jm_symbols_alloc_find_entry(inst.addr);
+
+            break;
+
+        case JM_OPCODE_REALLOC:
+            parser->alloc_ctx = jm_symbols_alloc_realloc_entry(inst);
+
+            break;
+
+        case JM_OPCODE_BACKTRACE:
+            if (parser->alloc_ctx == NULL && parser->map_ctx == NULL) break;
+
+            if (parser->alloc_key_count < MAX_BACKTRACE_COUNT)
+                parser->alloc_key.addrs[parser->alloc_key_count++] = inst.addr;
+
+            break;
+
+        case JM_OPCODE_EXEC_PATH:
+            (void) strcpy(summary->path, inst.ctx);
+
+            break;
+
+        case JM_OPCODE_FREE:
+            summary->stats.free_count++;
+
+            if (summary->timing.is_enabled)
+                jm_symbols_thread_find_or_add(inst.tid)->free_site = NULL;
+
+            jm_symbols_alloc_free_entry(jm_symbols_alloc_find_entry(
+                                            inst.addr),
+                                        inst);
+
+            break;
+
+        case JM_OPCODE_MAP:
+            summary->maps.map_count++;
+
+            parser->map_ctx = jm_symbols_map_add(inst);
+
+            break;
+
+        case JM_OPCODE_UNMAP:
+            summary->maps.unmap_count++;
+
+            jm_symbols_map_release(inst.addr,
+                                   (inst.alloc_size + page_size - 1)
+                                       & ~(page_size - 1));
+
+            break;
+
+        case JM_OPCODE_REMAP:
+            summary->maps.remap_count++;
+
+            parser->map_ctx = jm_symbols_map_remap(inst);
+
+            break;
+
+        case JM_OPCODE_MARK:
+            {
+                jmMark mark = { .timestamp = inst.timestamp };
+
+                // `[...] <COMMAND> <LABEL>`
+                (void) sscanf(inst.ctx, "%s %[^\n]", mark.command, mark.label);
+
+                /*
+                    NOTE: The backtrace of the last allocation might
+                    not be complete yet, so the dump is deferred until
+                    the allocation belongs to a site.
+                */
+
+                if (strcmp(mark.command, "dump") == 0) parser->dump_ctx = mark;
+
+                if (summary->marks.count < MAX_MARK_COUNT)
+                    summary->marks.buffer[summary->marks.count++] = mark;
+                else
+                    summary->marks.dropped++;
+            }
+
+            {
+                bool is_paused = (strncmp(inst.ctx, "pause", 5) == 0);
+                bool is_resumed = (strncmp(inst.ctx, "resume", 6) == 0);
+
+                if (is_paused && !summary->marks.is_paused)
+                    jm_symbols_alloc_pause();
+
+                if (is_paused || is_resumed)
+                    summary->marks.is_paused = is_paused;
+            }
+
+            break;
+
+        case JM_OPCODE_HISTOGRAM:
+            jm_symbols_histogram_add(inst);
+
+            break;
+
+        case JM_OPCODE_PROCESS:
+            // `[...] <PID> <PPID> <CLOCK_BASE>`
+            (void) sscanf(inst.ctx,
+                          "%d %d %" SCNu64,
+                          &summary->pid,
+                          &summary->ppid,
+                          &summary->clock_base);
+
+            break;
+
+        case JM_OPCODE_FILTERED:
+            // `[...] <ALLOCS> <BYTES> <FREES> <BYTES> <MAPS> <BYTES>`
+            (void) sscanf(inst.ctx,
+                          "%zu %zu %zu %zu %zu %zu",
+                          &summary->filtered.alloc_count,
+                          &summary->filtered.alloc_total,
+                          &summary->filtered.free_count,
+                          &summary->filtered.free_total,
+                          &summary->filtered.map_count,
+                          &summary->filtered.map_total);
+
+            break;
+
+        case JM_OPCODE_MODULE:
+            if (strncmp(inst.ctx, "linux-vdso.so", strlen("linux-vdso.so"))
+                == 0)
+                return;
+
+            dwfl_report_begin_add(dwfl);
+
+            Dwfl_Module *mod = dwfl_report_elf(
+                dwfl, inst.ctx, inst.ctx, -1, (GElf_Addr) inst.addr, false);
+
+            (void) dwfl_report_end(dwfl, NULL, NULL);
+
+            break;
+
+        case JM_OPCODE_REGION:
+            {
+                jmRegion *region =
+                    &summary->regions.buffer[summary->regions.count];
+
+                region->start = inst.addr;
+
+                (void) sscanf(inst.ctx, "%p", &region->end);
+            }
+
+            summary->regions.count++;
+
+            break;
+
+        case JM_OPCODE_SCAN:
+            {
+                size_t skipped = 0;
+
+                // `<SCAN_INDEX> <SKIPPED_REGIONS>`
+                (void) sscanf(inst.ctx, "%*d %zu", &skipped);
+
+                if (summary->cold.skipped < skipped)
+                    summary->cold.skipped = skipped;
+            }
+
+            jm_symbols_cold_begin_scan();
+
+            break;
+
+        case JM_OPCODE_THREAD:
+            {
+                jmThread *thread = jm_symbols_thread_find_or_add(inst.tid);
+
+                char name[MAX_BUFFER_SIZE] = { '\0' };
+
+                // `[...] <NAME>`
+                (void) sscanf(inst.ctx, "%*d %[^\n]", name);
+
+                (void) snprintf(thread->name, sizeof thread->name, "%s", name);
+
+                // NOTE: The ID of a thread that has exited can be reused
+                thread->is_exited = false;
+            }
+
+            break;
+
+        case JM_OPCODE_THREAD_EXIT:
+            jm_symbols_thread_find_or_add(inst.tid)->is_exited = true;
+
+            break;
+
+        case JM_OPCODE_FREE_TIME:
+            {
+                jmThread *thread = jm_symbols_thread_find_or_add(inst.tid);
+
+                jm_symbols_latency_add(&summary->timing.latency.free,
+                                       inst.duration);
+                jm_symbols_latency_add(&thread->latency.free, inst.duration);
+
+                if (thread->free_site != NULL)
+                    jm_symbols_latency_add(&thread->free_site->latency.free,
+                                           inst.duration);
+
+                thread->free_site = NULL;
+            }
+
+            break;
+
+        case JM_OPCODE_TIMING:
+            {
+                struct jmTiming_ *timing = &summary->timing;
+
+                uint64_t ticks = 0, nanoseconds = 0, overhead = 0;
+
+                size_t event_count = 0;
+
+                // `[...] <TICKS> <NANOSECONDS> <OVERHEAD> <EVENTS>`
+                (void) sscanf(inst.ctx,
+                              "%" SCNu64 " %" SCNu64 " %" SCNu64 " %zu",
+                              &ticks,
+                              &nanoseconds,
+                              &overhead,
+                              &event_count);
+
+                timing->ticks += ticks, timing->nanoseconds += nanoseconds;
+                timing->overhead += overhead;
+                timing->event_count += event_count;
+
+                timing->is_enabled = true;
+            }
+
+            break;
+
+        case JM_OPCODE_COLD:
+            {
+                void *end = NULL;
+
+                // `[...] <END_ADDRESS>`
+                (void) sscanf(inst.ctx, "%p", &end);
+
+                jm_symbols_cold_add((uintptr_t) inst.addr, (uintptr_t) end);
+            }
+
+            break;
+
+        default:
+            inst.opcode = JM_OPCODE_UNKNOWN;
+
+            break;
+    }
+
+    if (inst.opcode != JM_OPCODE_BACKTRACE && inst.opcode != JM_OPCODE_MARK) {
+        jm_symbols_heap_update(inst.timestamp);
+
+        if (parser->timestamp < inst.timestamp)
+            parser->timestamp = inst.timestamp;
+    }
+}
+
+static void jm_symbols_parse_end(void) {
+    jm_symbols_alloc_commit_entry(parser->alloc_ctx,
+                                  &parser->alloc_key,
+                                  parser->alloc_key_count);
+    jm_symbols_map_commit(parser->map_ctx,
+                          &parser->alloc_key,
+                          parser->alloc_key_count);
+
+    if (parser->dump_ctx.timestamp > 0) jm_symbols_dump_live(&parser->dump_ctx);
+
+    // NOTE: The last samples see the blocks that are still alive at exit
+    jm_symbols_sample_attribute(UINT64_MAX);
+
+    jm_symbols_cold_end_scan();
+
+    jm_symbols_histogram_end_flush();
+
+    jm_symbols_heap_record_peak();
+
+    // NOTE: The last epoch ends with the stream
+    jm_symbols_heap_take_snapshot(parser->timestamp);
+
+    {
+        jmAllocSite *head = summary->sites;
+
+        for (; head != NULL; head = head->hh.next)
+            jm_symbols_heap_find_growth(head);
+    }
+
+    {
+        // NOTE: Growth chains that are still alive end with the stream
+
+        jmAllocEntry *head = summary->entries;
+
+        for (; head != NULL; head = head->hh.next)
+            jm_symbols_alloc_end_chain(head);
+    }
+}
+
+static void jm_symbols_parse_log(FILE *fp) {
+    char buffer[MAX_BUFFER_SIZE];
+
+    while (fgets(buffer, sizeof buffer, fp) != NULL)
+        jm_symbols_parse_inst(buffer);
+
+    jm_symbols_parse_end();
+}
+
+/* ========================================================================> */
+
+static void jm_symbols_print_report(const char *trailer) {
+    if (trailer != NULL) printf("\n%s\n", trailer);
+
+    printf("\n");
+
+    jm_symbols_print_header(stdout);
+
+    printf("SUMMARY: \n"
+           "  %d allocs, %d frees (%ld bytes alloc-ed)\n"
+           "  %d reallocs (%d moves, %ld bytes copied)\n"
+           "  %d temporary allocs (%.2f%%)\n"
+           "  %d mismatched frees\n"
+           "  %ld bytes of slack (usable - requested)\n"
+           "  %d maps, %d unmaps, %d remaps "
+           "(%ld bytes mapped, %ld bytes at peak)\n\n",
+           summary->stats.alloc_count,
+           summary->stats.free_count,
+           summary->stats.total,
+           summary->stats.realloc_count,
+           summary->stats.move_count,
+           summary->stats.copied,
+           summary->stats.temp_count,
+           (summary->stats.alloc_count > 0)
+               ? (100.0 * summary->stats.temp_count)
+                     / summary->stats.alloc_count
+               : 0.0,
+           summary->stats.mismatch_count,
+           summary->stats.slack,
+           summary->maps.map_count,
+           summary->maps.unmap_count,
+           summary->maps.remap_count,
+           summary->maps.live,
+           summary->maps.peak);
+
+    if (summary->filtered.alloc_count + summary->filtered.free_count
+            + summary->filtered.map_count
+        > 0)
+        printf("FILTERED: \n"
+               "  %ld allocs, %ld frees, %ld maps "
+               "(%ld bytes alloc-ed, %ld bytes freed, %ld bytes mapped)\n\n",
+               summary->filtered.alloc_count,
+               summary->filtered.free_count,
+               summary->filtered.map_count,
+               summary->filtered.alloc_total,
+               summary->filtered.free_total,
+               summary->filtered.map_total);
+
+    jm_symbols_print_size_classes();
+    jm_symbols_print_histogram();
+
+    HASH_SORT(summary->sites, jm_symbols_site_compare);
+
+    jm_symbols_print_snapshots();
+    jm_symbols_print_peak();
+    jm_symbols_print_growth();
+    jm_symbols_print_samples();
+    jm_symbols_print_faults();
+    jm_symbols_print_placement();
+    jm_symbols_print_cold();
+    jm_symbols_print_threads();
+    jm_symbols_print_cross_frees();
+    jm_symbols_print_latency();
+    jm_symbols_print_marks();
+
+    {
+        jmAllocEntry *head = summary->entries;
+
+        for (; head != NULL; head = head->hh.next) {
+            if (head->is_paused) continue;
+
+            printf("  ~ alloc #%d (! %" PRIu64 " ms) "
+                   "-> [%ld bytes @ %p, %s]: \n",
+                   head->index,
+                   head->timestamp,
+                   head->alloc_size,
+                   head->key,
+                   alloc_kind_names[head->kind]);
+
+            if (head->site != NULL)
+                jm_symbols_print_backtraces(stdout, &head->site->traces);
+
+            printf("\n");
+        }
+    }
+
+    if (summary->sites != NULL) printf("SITES: \n");
+
+    {
+        jmAllocSite *head = summary->sites;
+
+        for (; head != NULL; head = head->hh.next) {
+            printf("  ~ site #%d -> [%ld allocs, %ld frees, "
+                   "%ld bytes alloc-ed]: \n",
+                   head->index,
+                   head->stats.alloc_count,
+                   head->stats.free_count,
+                   head->stats.total);
+
+            if (head->stats.slack > 0)
+                printf("    slack: %ld bytes (%.2f%% of usable)\n",
+                       head->stats.slack,
+                       (100.0 * head->stats.slack) / head->stats.total);
+
+            if (head->stats.at_peak > 0)
+                printf("    at peak: %ld bytes (%.2f%% of peak)\n",
+                       head->stats.at_peak,
+                       (100.0 * head->stats.at_peak) / summary->peak.recorded);
+
+            if (head->stats.temp_count > 0)
+                printf("    temporary: %ld allocs (%.2f%%)\n",
+                       head->stats.temp_count,
+                       (100.0 * head->stats.temp_count)
+                           / head->stats.alloc_count);
+
+            if (head->stats.cross_free_count > 0)
+                printf("    cross-thread frees: %ld (%.2f%% of frees)\n",
+                       head->stats.cross_free_count,
+                       (100.0 * head->stats.cross_free_count)
+                           / head->stats.free_count);
+
+            if (head->latency.alloc.count > 0)
+                jm_symbols_print_latency_histogram("    allocator",
+                                                   &head->latency.alloc);
+
+            jm_symbols_print_reallocs(head);
+            jm_symbols_print_mismatches(head);
+            jm_symbols_print_mappings(head);
+            jm_symbols_print_site_samples(head);
+
+            if (head->cold.peak > 0)
+                printf("    cold: %ld bytes at most (%ld in the last scan)\n",
+                       head->cold.peak,
+                       head->cold.last);
+
+            jm_symbols_print_lifetimes(head);
+            jm_symbols_print_backtraces(stdout, &head->traces);
+
+            printf("\n");
+        }
+    }
+}
+
+static void jm_symbols_print_processes(void) {
+    if (processes.count == 0) return;
+
+    jmProcess total = { .alloc_count = 0 };
+
+    for (size_t i = 0; i < processes.count; i++) {
+        total.alloc_count += processes.buffer[i].alloc_count;
+        total.free_count += processes.buffer[i].free_count;
+        total.live_count += processes.buffer[i].live_count;
+
+        total.heap += processes.buffer[i].heap;
+        total.mapped += processes.buffer[i].mapped;
+        total.peak += processes.buffer[i].peak;
+    }
+
+    /*
+        NOTE: Processes do not share a clock, so the merged peak is only 
+        an upper bound (the sum of the peaks of every process).
+    */
+
+    printf("\nPROCESSES: \n"
+           "  %ld processes, %ld allocs, %ld frees "
+           "(%ld allocs alive, %ld bytes alloc-ed, %ld bytes mapped)\n"
+           "  <= %ld bytes at peak (sum of all processes)\n\n",
+           processes.count + processes.dropped,
+           total.alloc_count,
+           total.free_count,
+           total.live_count,
+           total.heap,
+           total.mapped,
+           total.peak);
+
+    for (size_t i = 0; i < processes.count; i++) {
+        const jmProcess *process = &processes.buffer[i];
+
+        printf("  ~ pid %d (ppid %d) -> [%ld allocs, %ld frees, "
+               "%ld bytes alloc-ed, %ld bytes mapped, %ld bytes at peak]: \n"
+               "    %s\n\n",
+               process->pid,
+               process->ppid,
+               process->alloc_count,
+               process->free_count,
+               process->heap,
+               process->mapped,
+               process->peak,
+               process->path);
+    }
+
+    if (processes.dropped > 0)
+        printf("  (%ld more processes not shown)\n\n", processes.dropped);
+}
+
+static void jm_symbols_print_header(FILE *fp) {
+    fprintf(fp, "jmprof v" JMPROF_VERSION " by " JMPROF_AUTHOR "\n\n");
+
+    // NOTE: Streams written by older versions do not have a process record
+    if (summary->pid > 0)
+        fprintf(fp,
+                "> %s (pid %d, ppid %d)\n\n",
+                summary->path,
+                summary->pid,
+                summary->ppid);
+    else
+        fprintf(fp, "> %s\n\n", summary->path);
+}
+
+static void jm_symbols_print_backtraces(FILE *fp,
+                                        const struct jmBacktraces_ *traces) {
+    for (int i = 0; i < traces->count; i++) {
+        jmBacktrace bt = traces->buffer[i];
+
+        fprintf(fp,
+                "    @ 0x%jx: %s (%s:%d:%d)\n"
+                "      (in %s)\n",
+                bt.addr,
+                bt.sym.name,
+                bt.src.name,
+                bt.src.line,
+                bt.src.column,
+                bt.mod.name);
+    }
+}
+
+static void jm_symbols_print_lifetimes(const jmAllocSite *site) {
+    if (site->stats.free_count == 0) return;
+
+    printf("    lifetimes:");
+
+    for (int i = 0; i < MAX_LIFETIME_COUNT; i++) {
+        if (site->lifetimes[i] == 0) continue;
+
+        printf(" %s: %ld", lifetime_labels[i], site->lifetimes[i]);
+    }
+
+    printf("\n");
+}
+
+static void jm_symbols_print_reallocs(const jmAllocSite *site) {
+    if (site->reallocs.count == 0) return;
+
+    printf("    reallocs: %ld (%ld moves, %ld bytes copied)\n",
+           site->reallocs.count,
+           site->reallocs.move_count,
+           site->reallocs.copied);
+
+    if (site->reallocs.chain_count == 0) return;
+
+    printf("    growth chains: %ld (avg. final size: %ld bytes, "
+           "max. final size: %ld bytes)\n",
+           site->reallocs.chain_count,
+           site->reallocs.final_total / site->reallocs.chain_count,
+           site->reallocs.final_max);
+}
+
+static void jm_symbols_print_mismatches(const jmAllocSite *site) {
+    for (int i = 0; i < JM_ALLOC_KIND_COUNT; i++) {
+        if (site->mismatches[i] == 0) continue;
+
+        printf("    mismatched frees: %ld (allocated with `%s`, "
+               "freed with `%s`)\n",
+               site->mismatches[i],
+               alloc_kind_names[site->kind],
+               free_kind_names[i]);
+    }
+}
+
+static void jm_symbols_print_mappings(const jmAllocSite *site) {
+    if (site->maps.count == 0) return;
+
+    printf("    mappings: %ld maps, %ld unmaps (%ld bytes mapped, "
+           "%ld bytes at peak, %ld bytes still mapped)\n",
+           site->maps.count,
+           site->maps.unmap_count,
+           site->maps.total,
+           site->maps.peak,
+           site->maps.live);
+
+    if (site->maps.remap_count == 0) return;
+
+    printf("    remaps: %ld (%ld bytes grown)\n",
+           site->maps.remap_count,
+           site->maps.growth);
+}
+
+static void jm_symbols_print_snapshots(void) {
+    if (summary->snapshots.count == 0) return;
+
+    size_t max = summary->peak.heap + summary->peak.mapped;
+
+    printf("HEAP OVER TIME: \n");
+
+    for (int i = 0; i < summary->snapshots.count; i++) {
+        const jmSnapshot *snapshot = &summary->snapshots.buffer[i];
+
+        size_t live = snapshot->heap + snapshot->mapped;
+
+        char bar[41] = { '\0' };
+
+        // NOTE: Each bar is drawn relative to the peak footprint
+        (void) memset(bar, '#', (max > 0) ? (40 * live) / max : 0);
+
+        printf("  %12.3f ms |%-40s| %ld bytes",
+               snapshot->timestamp / 1000000.0,
+               bar,
+               live);
+
+        for (int j = 0; j < MAX_TOP_SITE_COUNT; j++) {
+            if (snapshot->sites[j].site == NULL) break;
+
+            printf("%s#%d: %ld",
+                   (j == 0) ? " (" : ", ",
+                   snapshot->sites[j].site->index,
+                   snapshot->sites[j].live);
+        }
+
+        printf("%s\n", (snapshot->sites[0].site != NULL) ? ")" : "");
+    }
+
+    printf("\n");
+}
+
+static void jm_symbols_print_peak(void) {
+    if (summary->peak.recorded == 0) return;
+
+    printf("PEAK: \n"
+           "  %ld bytes (%ld heap, %ld mapped) at %.3f ms\n",
+           summary->peak.heap + summary->peak.mapped,
+           summary->peak.heap,
+           summary->peak.mapped,
+           summary->peak.timestamp / 1000000.0);
+
+    jmAllocSite **sites = calloc(HASH_COUNT(summary->sites) + 1,
+                                 sizeof(jmAllocSite *));
+
+    size_t count = 0;
+
+    jmAllocSite *head = summary->sites;
+
+    for (; head != NULL; head = head->hh.next)
+        if (head->stats.at_peak > 0) sites[count++] = head;
+
+    qsort(sites, count, sizeof(jmAllocSite *), jm_symbols_site_compare_peak);
+
+    for (int i = 0; i < count; i++)
+        printf("  ~ site #%d -> %ld bytes (%.2f%%)\n",
+               sites[i]->index,
+               sites[i]->stats.at_peak,
+               (100.0 * sites[i]->stats.at_peak) / summary->peak.recorded);
+
+    printf("\n");
+
+    free(sites);
+}
+
+static void jm_symbols_print_growth(void) {
+    jmAllocSite **sites = calloc(HASH_COUNT(summary->sites) + 1,
+                                 sizeof(jmAllocSite *));
+
+    size_t count = 0;
+
+    jmAllocSite *head = summary->sites;
+
+    /*
+        NOTE: A site is "growing" if its live set never shrinks between 
+        two epochs, or if it grows faster than the given threshold.
+    */
+
+    for (; head != NULL; head = head->hh.next)
+        if (head->growth.rate > 0.0
+            && (head->growth.is_monotonic
+                || (growth_threshold > 0.0
+                    && head->growth.rate >= growth_threshold)))
+            sites[count++] = head;
+
+    if (count > 0) {
+        qsort(sites,
+              count,
+              sizeof(jmAllocSite *),
+              jm_symbols_site_compare_growth);
+
+        printf("GROWTH (%ld epochs of %.3f ms): \n",
+               summary->snapshots.count,
+               summary->snapshots.interval / 1000000.0);
+
+        for (int i = 0; i < count; i++) {
+            printf("  ~ site #%d -> [%.2f bytes/s%s, %ld bytes alive]: \n",
+                   sites[i]->index,
+                   sites[i]->growth.rate,
+                   sites[i]->growth.is_monotonic ? ", monotonic" : "",
+                   sites[i]->stats.live + sites[i]->maps.live);
+
+            jm_symbols_print_backtraces(stdout, &sites[i]->traces);
+
+            printf("\n");
+        }
+    }
+
+    free(sites);
+}
+
+static void jm_symbols_print_samples(void) {
+    bool is_empty = true;
+
+    for (int i = 0; i < sample_log.counter_count; i++) {
+        const struct jmSampleStats_ *stats = &summary->samples[i];
+
+        size_t total = stats->heap_count + stats->map_count
+                       + stats->other_count;
+
+        if (total == 0) continue;
+
+        if (is_empty) printf("MEMORY ACCESSES (sampled data addresses): \n");
+
+        is_empty = false;
+
+        printf("  %s: %ld samples (%.2f%% in heap blocks, %.2f%% in "
+               "mappings, %.2f%% elsewhere)\n",
+               sample_log.names[i],
+               total,
+               (100.0 * stats->heap_count) / total,
+               (100.0 * stats->map_count) / total,
+               (100.0 * stats->other_count) / total);
+
+        jm_symbols_print_sample_totals(&sample_log.totals[i]);
+
+        jmAllocSite **sites = calloc(HASH_COUNT(summary->sites) + 1,
+                                     sizeof(jmAllocSite *));
+
+        size_t count = 0;
+
+        jmAllocSite *head = summary->sites;
+
+        for (; head != NULL; head = head->hh.next)
+            if (head->samples[i].count > 0) sites[count++] = head;
+
+        sample_counter = i;
+
+        qsort(sites,
+              count,
+              sizeof(jmAllocSite *),
+              jm_symbols_site_compare_samples);
+
+        for (int j = 0; j < count && j < MAX_TOP_SITE_COUNT; j++) {
+            const struct jmAllocSiteSamples_ *samples = &sites[j]->samples[i];
+
+            printf("    site #%d: %ld samples (%.2f%%)",
+                   sites[j]->index,
+                   samples->count,
+                   (100.0 * samples->count) / total);
+
+            if (samples->weighted_count > 0)
+                printf(", %.1f cycles per load",
+                       (double) samples->weight_total
+                           / samples->weighted_count);
+
+            printf("\n");
+        }
+
+        printf("\n");
+
+        free(sites);
+    }
+
+    if (!is_empty && sample_log.lost_count > 0)
+        printf("  (%ld samples lost while recording)\n\n",
+               sample_log.lost_count);
+}
+
+static void jm_symbols_print_sample_totals(
+    const struct jmSampleTotals_ *totals) {
+    if (totals->time_running >= totals->time_enabled) {
+        printf("    %" PRIu64 " events in the whole run (exact count)\n",
+               totals->value);
+
+        return;
+    }
+
+    /*
+        NOTE: The kernel multiplexes the events when there are more than
+        the PMU can count at once, so the value of an event that was only
+        counted for a part of the run is scaled up to the whole run. The
+        less of the time it was counted, the less the estimate is to be
+        trusted.
+    */
+
+    if (totals->time_running == 0) {
+        printf("    no events in the whole run (never scheduled)\n");
+
+        return;
+    }
+
+    double ratio = (double) totals->time_running / totals->time_enabled;
+
+    const char *confidence = (ratio >= 0.75)   ? "high"
+                             : (ratio >= 0.25) ? "medium"
+                                               : "low";
+
+    printf("    ~%.0f events in the whole run (scaled from %" PRIu64
+           ", counted %.2f%% of the time, %s confidence)\n",
+           totals->value / ratio,
+           totals->value,
+           100.0 * ratio,
+           confidence);
+}
+
+static void jm_symbols_print_site_samples(const jmAllocSite *site) {
+    for (int i = 0; i < sample_log.counter_count; i++) {
+        const struct jmAllocSiteSamples_ *samples = &site->samples[i];
+
+        if (samples->count == 0) continue;
+
+        if (i == sample_log.fault_counter) {
+            double faults = jm_symbols_sample_get_faults(site);
+
+            printf("    faults: ~%.0f (~%.0f bytes of RSS growth)\n",
+                   faults,
+                   faults * page_size);
+
+            continue;
+        }
+
+        printf("    accesses: %ld samples of %s",
+               samples->count,
+               sample_log.names[i]);
+
+        if (samples->weighted_count > 0)
+            printf(" (%.1f cycles per load)",
+                   (double) samples->weight_total / samples->weighted_count);
+
+        printf("\n");
+    }
+}
+
+static void jm_symbols_print_faults(void) {
+    int i = sample_log.fault_counter;
+
+    if (i < 0 || i >= sample_log.counter_count) return;
+
+    jmAllocSite **sites = calloc(HASH_COUNT(summary->sites) + 1,
+                                 sizeof(jmAllocSite *));
+
+    size_t count = 0;
+
+    jmAllocSite *head = summary->sites;
+
+    for (; head != NULL; head = head->hh.next)
+        if (head->samples[i].count > 0) sites[count++] = head;
+
+    if (count == 0) {
+        free(sites);
+
+        return;
+    }
+
+    sample_counter = i;
+
+    qsort(sites, count, sizeof(jmAllocSite *), jm_symbols_site_compare_samples);
+
+    printf("FIRST TOUCH (page faults in heap blocks and mappings): \n");
+
+    for (int j = 0; j < count && j < MAX_TOP_SITE_COUNT; j++) {
+        double faults = jm_symbols_sample_get_faults(sites[j]);
+
+        size_t total = sites[j]->stats.total + sites[j]->maps.total;
+
+        printf("  ~ site #%d -> ~%.0f faults (~%.0f bytes of RSS growth, "
+               "%.2f%% of alloc-ed bytes)\n",
+               sites[j]->index,
+               faults,
+               faults * page_size,
+               (total > 0) ? (100.0 * faults * page_size) / total : 0.0);
+
+        /*
+            NOTE: A block that is freed and allocated again is often given
+            fresh pages, which are faulted in (and zeroed) all over again.
+            Otherwise, the cost of the faults can be paid up front.
+        */
+
+        size_t alloc_count = sites[j]->stats.alloc_count
+                             + sites[j]->maps.count;
+        size_t free_count = sites[j]->stats.free_count
+                            + sites[j]->maps.unmap_count;
+
+        if (alloc_count > 1 && free_count > 0)
+            printf("    hint: pool or reuse these blocks (%ld allocs, "
+                   "%ld frees)\n",
+                   alloc_count,
+                   free_count);
+        else
+            printf("    hint: pre-fault these blocks (e.g. `MAP_POPULATE`)\n");
+    }
+
+    printf("\n");
+
+    free(sites);
+}
+
+static void jm_symbols_print_placement(void) {
+    const struct jmPlacement_ *placement = &summary->placement;
+
+    if (placement->count + placement->unknown_count == 0) return;
+
+    printf("NUMA PLACEMENT (nodes of the sampled data addresses): \n");
+
+    if (placement->count == 0) {
+        printf("  the nodes of %ld sampled pages are unknown\n\n",
+               placement->unknown_count);
+
+        return;
+    }
+
+    // NOTE: Every access is local if there is only one node
+    if (sample_log.node_count <= 1) {
+        printf("  1 node, %ld samples (all of them local)\n\n",
+               placement->count);
+
+        return;
+    }
+
+    printf("  %d nodes, %ld samples (%.2f%% from a CPU on another node, "
+           "%ld of an unknown node)\n",
+           sample_log.node_count,
+           placement->count,
+           (100.0 * placement->remote_count) / placement->count,
+           placement->unknown_count);
+
+    jmAllocSite **sites = calloc(HASH_COUNT(summary->sites) + 1,
+                                 sizeof(jmAllocSite *));
+
+    size_t count = 0;
+
+    jmAllocSite *head = summary->sites;
+
+    for (; head != NULL; head = head->hh.next)
+        if (head->placement.count > 0) sites[count++] = head;
+
+    qsort(sites, count, sizeof(jmAllocSite *), jm_symbols_site_compare_remote);
+
+    // NOTE: Each page fault sample is a page that was placed on a node
+    double scale = (sample_log.fault_counter >= 0)
+                       ? jm_symbols_sample_get_scale(sample_log.fault_counter)
+                       : 0.0;
+
+    for (int i = 0; i < count && i < MAX_TOP_SITE_COUNT; i++) {
+        const struct jmAllocSitePlacement_ *site = &sites[i]->placement;
+
+        // NOTE: A site whose pages are mostly accessed from afar is flagged
+        printf("  ~ site #%d -> %ld samples (%.2f%% from another node)%s\n",
+               sites[i]->index,
+               site->count,
+               (100.0 * site->remote_count) / site->count,
+               (2 * site->remote_count > site->count) ? " <- cross-node"
+                                                       : "");
+
+        int touch_node = -1;
+
+        for (int n = 0; n < sample_log.node_count; n++) {
+            const struct jmAllocSiteNode_ *node = &site->nodes[n];
+
+            if (node->touch_count > 0
+                && (touch_node < 0
+                    || site->nodes[touch_node].touch_count < node->touch_count))
+                touch_node = n;
+
+            if (node->fault_count + node->access_count == 0) continue;
+
+            printf("      node %d:", n);
+
+            if (sample_log.fault_counter >= 0)
+                printf(" ~%.0f bytes faulted in,",
+                       scale * node->fault_count * page_size);
+
+            printf(" %ld accesses, %ld samples from another node\n",
+                   node->access_count,
+                   node->remote_count);
+        }
+
+        if (touch_node >= 0)
+            printf("      first touched from node %d\n", touch_node);
+    }
+
+    printf("\n");
+
+    free(sites);
+}
+
+static void jm_symbols_print_threads(void) {
+    size_t count = HASH_COUNT(summary->threads);
+
+    // NOTE: A single-threaded program has nothing to compare
+    if (count <= 1) return;
+
+    jmThread **threads = calloc(count, sizeof(jmThread *));
+
+    count = 0;
+
+    jmThread *head = summary->threads;
+
+    for (; head != NULL; head = head->hh.next)
+        threads[count++] = head;
+
+    qsort(threads, count, sizeof(jmThread *), jm_symbols_thread_compare);
+
+    printf("THREADS (by bytes alloc-ed): \n");
+
+    for (int i = 0; i < count && i < MAX_TOP_SITE_COUNT; i++) {
+        const struct jmThreadStats_ *stats = &threads[i]->stats;
+
+        printf("  ~ thread %d (%s) -> [%ld allocs, %ld bytes alloc-ed, "
+               "%ld frees, %ld bytes freed]%s\n",
+               threads[i]->key,
+               (threads[i]->name[0] != '\0') ? threads[i]->name : "?",
+               stats->alloc_count,
+               stats->alloc_total,
+               stats->free_count,
+               stats->free_total,
+               threads[i]->is_exited ? " (exited)" : "");
+
+        if (stats->cross_free_count > 0)
+            printf("    frees of other threads' blocks: %ld (%ld bytes)\n",
+                   stats->cross_free_count,
+                   stats->cross_free_total);
+    }
+
+    if (count > MAX_TOP_SITE_COUNT)
+        printf("  (%ld more threads)\n", count - MAX_TOP_SITE_COUNT);
+
+    printf("\n");
+
+    free(threads);
+}
+
+static void jm_symbols_print_cross_frees(void) {
+    if (summary->stats.cross_free_count == 0) return;
+
+    printf("CROSS-THREAD FREES (blocks freed by another thread): \n"
+           "  %ld blocks, %ld bytes (%.2f%% of frees)\n",
+           summary->stats.cross_free_count,
+           summary->stats.cross_free_total,
+           (summary->stats.free_count > 0)
+               ? (100.0 * summary->stats.cross_free_count)
+                     / summary->stats.free_count
+               : 0.0);
+
+    {
+        size_t count = HASH_COUNT(summary->thread_pairs);
+
+        jmThreadPair **pairs = calloc(count + 1, sizeof(jmThreadPair *));
+
+        count = 0;
+
+        jmThreadPair *head = summary->thread_pairs;
+
+        for (; head != NULL; head = head->hh.next)
+            pairs[count++] = head;
+
+        qsort(pairs,
+              count,
+              sizeof(jmThreadPair *),
+              jm_symbols_thread_pair_compare);
+
+        for (int i = 0; i < count && i < MAX_TOP_SITE_COUNT; i++) {
+            jmThread *producer = jm_symbols_thread_find_or_add(
+                pairs[i]->alloc_tid);
+            jmThread *consumer = jm_symbols_thread_find_or_add(
+                pairs[i]->free_tid);
+
+            printf("  ~ thread %d (%s) -> thread %d (%s): %ld blocks, "
+                   "%ld bytes\n",
+                   producer->key,
+                   (producer->name[0] != '\0') ? producer->name : "?",
+                   consumer->key,
+                   (consumer->name[0] != '\0') ? consumer->name : "?",
+                   pairs[i]->count,
+                   pairs[i]->total);
+        }
+
+        free(pairs);
+    }
+
+    {
+        jmAllocSite **sites = calloc(HASH_COUNT(summary->sites) + 1,
+                                     sizeof(jmAllocSite *));
+
+        size_t count = 0;
+
+        jmAllocSite *head = summary->sites;
+
+        for (; head != NULL; head = head->hh.next)
+            if (head->stats.cross_free_count > 0) sites[count++] = head;
+
+        qsort(sites,
+              count,
+              sizeof(jmAllocSite *),
+              jm_symbols_site_compare_cross_frees);
+
+        for (int i = 0; i < count && i < MAX_TOP_SITE_COUNT; i++)
+            printf("  ~ site #%d -> %ld blocks, %ld bytes (%.2f%% of its "
+                   "frees)\n",
+                   sites[i]->index,
+                   sites[i]->stats.cross_free_count,
+                   sites[i]->stats.cross_free_total,
+                   (100.0 * sites[i]->stats.cross_free_count)
+                       / sites[i]->stats.free_count);
+
+        free(sites);
+    }
+
+    printf("\n");
+}
+
+static void jm_symbols_print_latency(void) {
+    const struct jmTiming_ *timing = &summary->timing;
+
+    const jmLatency *latency = &timing->latency;
+
+    if (latency->alloc.count + latency->free.count == 0) return;
+
+    printf("ALLOCATOR LATENCY (time spent in the real allocator): \n");
+
+    jm_symbols_print_latency_histogram("  allocs", &latency->alloc);
+    jm_symbols_print_latency_histogram("  frees", &latency->free);
+
+    double scale = jm_symbols_latency_get_scale();
+
+    /*
+        NOTE: The profiler's own cost (unwinding the stack and writing
+        the events) is measured apart from the allocator's, so that one
+        does not inflate the other.
+    */
+
+    if (timing->event_count > 0) {
+        uint64_t total = timing->overhead + latency->alloc.total
+                         + latency->free.total;
+
+        printf("  profiler: ~%.0f %s per event (%.2f%% of the time spent "
+               "in both)\n",
+               (double) timing->overhead * ((scale > 0.0) ? scale : 1.0)
+                   / timing->event_count,
+               (scale > 0.0) ? "ns" : "ticks",
+               (total > 0) ? (100.0 * timing->overhead) / total : 0.0);
+    }
+
+    {
+        jmAllocSite **sites = calloc(HASH_COUNT(summary->sites) + 1,
+                                     sizeof(jmAllocSite *));
+
+        size_t count = 0;
+
+        jmAllocSite *head = summary->sites;
+
+        for (; head != NULL; head = head->hh.next)
+            if (head->latency.alloc.count + head->latency.free.count > 0)
+                sites[count++] = head;
+
+        qsort(sites,
+              count,
+              sizeof(jmAllocSite *),
+              jm_symbols_site_compare_latency);
+
+        for (int i = 0; i < count && i < MAX_TOP_SITE_COUNT; i++) {
+            printf("  ~ site #%d: \n", sites[i]->index);
+
+            jm_symbols_print_latency_histogram("      allocs",
+                                               &sites[i]->latency.alloc);
+            jm_symbols_print_latency_histogram("      frees",
+                                               &sites[i]->latency.free);
+        }
+
+        free(sites);
+    }
+
+    // NOTE: Contention on the arenas shows up as slow threads
+    if (HASH_COUNT(summary->threads) > 1) {
+        jmThread **threads = calloc(HASH_COUNT(summary->threads),
+                                    sizeof(jmThread *));
+
+        size_t count = 0;
+
+        jmThread *head = summary->threads;
+
+        for (; head != NULL; head = head->hh.next)
+            threads[count++] = head;
+
+        qsort(threads,
+              count,
+              sizeof(jmThread *),
+              jm_symbols_thread_compare_latency);
+
+        for (int i = 0; i < count && i < MAX_TOP_SITE_COUNT; i++) {
+            printf("  ~ thread %d (%s): \n",
+                   threads[i]->key,
+                   (threads[i]->name[0] != '\0') ? threads[i]->name : "?");
+
+            jm_symbols_print_latency_histogram("      allocs",
+                                               &threads[i]->latency.alloc);
+            jm_symbols_print_latency_histogram("      frees",
+                                               &threads[i]->latency.free);
+        }
+
+        free(threads);
+    }
+
+    printf("\n");
+}
+
+static void jm_symbols_print_latency_histogram(
+    const char *name,
+    const struct jmLatencyHistogram_ *histogram) {
+    if (histogram->count == 0) return;
+
+    double scale = jm_symbols_latency_get_scale();
+
+    const char *unit = (scale > 0.0) ? "ns" : "ticks";
+
+    if (scale == 0.0) scale = 1.0;
+
+    printf("%s: %ld calls, p50 ~%.0f, p90 ~%.0f, p99 ~%.0f, max %.0f %s "
+           "(%.0f %s in total)\n",
+           name,
+           histogram->count,
+           scale * jm_symbols_latency_get_percentile(histogram, 0.50),
+           scale * jm_symbols_latency_get_percentile(histogram, 0.90),
+           scale * jm_symbols_latency_get_percentile(histogram, 0.99),
+           scale * histogram->max,
+           unit,
+           scale * histogram->total,
+           unit);
+}
+
+static void jm_symbols_print_cold(void) {
+    if (summary->cold.scan_count == 0) return;
+
+    printf("COLD MEMORY (live bytes not written between two scans): \n"
+           "  %ld scans, %ld bytes cold in the last scan, %ld bytes at most"
+           "\n",
+           summary->cold.scan_count,
+           summary->cold.last,
+           summary->cold.peak);
+
+    if (summary->cold.skipped > 0)
+        printf("  (%ld heap regions past the first %d were not scanned)\n",
+               summary->cold.skipped,
+               MAX_REGION_COUNT);
+
+    jmAllocSite **sites = calloc(HASH_COUNT(summary->sites) + 1,
+                                 sizeof(jmAllocSite *));
+
+    size_t count = 0;
+
+    jmAllocSite *head = summary->sites;
+
+    for (; head != NULL; head = head->hh.next)
+        if (head->cold.peak > 0) sites[count++] = head;
+
+    qsort(sites, count, sizeof(jmAllocSite *), jm_symbols_site_compare_cold);
+
+    for (int i = 0; i < count && i < MAX_TOP_SITE_COUNT; i++) {
+        const struct jmAllocSiteCold_ *cold = &sites[i]->cold;
+
+        printf("  ~ site #%d -> %ld bytes cold at most (%ld in the last scan, "
+               "%.2f%% of its live bytes)\n",
+               sites[i]->index,
+               cold->peak,
+               cold->last,
+               (cold->live > 0) ? (100.0 * cold->last) / cold->live : 0.0);
+    }
+
+    printf("\n");
+
+    free(sites);
+}
+
+static void jm_symbols_print_marks(void) {
+    if (summary->marks.count == 0) return;
+
+    printf("MARKS: \n");
+
+    for (int i = 0; i < summary->marks.count; i++)
+        printf("  %12.3f ms: %-6s %s\n",
+               summary->marks.buffer[i].timestamp / 1000000.0,
+               summary->marks.buffer[i].command,
+               summary->marks.buffer[i].label);
+
+    if (summary->marks.dropped > 0)
+        printf("  (%ld more marks not shown)\n", summary->marks.dropped);
+
+    if (summary->marks.paused_count > 0)
+        printf("  %ld allocs were still alive when the recording was paused "
+               "(not reported as leaks)\n",
+               summary->marks.paused_count);
+
+    printf("\n");
+}
+
+static void jm_symbols_dump_live(const jmMark *mark) {
+    /*
+        NOTE: The target keeps running while we write the dump, since we
+        only need the allocations we have already seen.
+    */
+
+    char path[MAX_BUFFER_SIZE], now[MAX_BUFFER_SIZE];
+
+    time_t raw_time = time(NULL);
+
+    (void) strftime(now, sizeof now, "%Y%m%d-%H%M%S", localtime(&raw_time));
+
+    const char *dir = getenv("JMPROF_DUMP_DIR");
+
+    (void) snprintf(path,
+                    sizeof path,
+                    "%s/jmprof-dump.%s.%ld.txt",
+                    (dir != NULL) ? dir : ".",
+                    now,
+                    ++summary->marks.dump_count);
+
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        fprintf(stderr,
+                "jmprof-ip: error: unable to open file '%s'\n",
+                path);
+
+        return;
+    }
+
+    jmAllocSite **sites = calloc(HASH_COUNT(summary->sites) + 1,
+                                 sizeof(jmAllocSite *));
+
+    size_t count = 0;
+
+    jmAllocSite *head = summary->sites;
+
+    for (; head != NULL; head = head->hh.next)
+        if (head->stats.live + head->maps.live > 0) sites[count++] = head;
+
+    qsort(sites, count, sizeof(jmAllocSite *), jm_symbols_site_compare_live);
+
+    jm_symbols_print_header(fp);
+
+    fprintf(fp,
+            "LIVE HEAP (at %.3f ms, %s): \n"
+            "  %d allocs alive (%ld bytes alloc-ed, %ld bytes mapped)\n\n",
+            mark->timestamp / 1000000.0,
+            mark->label,
+            HASH_COUNT(summary->entries),
+            summary->stats.total,
+            summary->maps.live);
+
+    for (int i = 0; i < count; i++) {
+        fprintf(fp,
+                "  ~ site #%d -> [%ld allocs alive, %ld bytes alloc-ed, "
+                "%ld bytes mapped]: \n",
+                sites[i]->index,
+                sites[i]->stats.live_count,
+                sites[i]->stats.live,
+                sites[i]->maps.live);
+
+        jm_symbols_print_backtraces(fp, &sites[i]->traces);
+
+        fprintf(fp, "\n");
+    }
+
+    free(sites);
+
+    fclose(fp);
+
+    fprintf(stderr, "jmprof-ip: info: dumped the live heap to '%s'\n", path);
+}
+
+static void jm_symbols_print_histogram(void) {
+    if (summary->histogram.flush_count == 0) return;
+
+    int count = 0;
+
+    for (int i = 0; i < MAX_SIZE_CLASS_COUNT; i++)
+        if (summary->histogram.buckets[i].alloc_count > 0
+            || summary->histogram.buckets[i].free_count > 0)
+            count++;
+
+    if (count == 0) return;
+
+    printf("HISTOGRAM (allocs by requested size, frees by usable size): \n");
+
+    for (int i = 0; i < MAX_SIZE_CLASS_COUNT; i++) {
+        const struct jmHistogramBucket_ *bucket =
+            &summary->histogram.buckets[i];
+
+        if (bucket->alloc_count == 0 && bucket->free_count == 0) continue;
+
+        // NOTE: See `jm_symbols_print_size_classes()`
+        if (i < MAX_SIZE_CLASS_COUNT - 1)
+            printf("  <= %-12ju : ", (uintmax_t) 1 << i);
+        else
+            printf("  >  %-12s : ", "2^63");
+
+        printf("%ld allocs (%ld bytes), %ld frees (%ld bytes)\n",
+               bucket->alloc_count,
+               bucket->alloc_total,
+               bucket->free_count,
+               bucket->free_total);
+    }
+
+    double duration = summary->histogram.last_timestamp / 1e9;
+
+    printf("  %.2f allocs/s on average, %.2f allocs/s at most "
+           "(%ld flushes)\n\n",
+           (duration > 0.0) ? summary->histogram.last_alloc_count / duration
+                            : 0.0,
+           summary->histogram.max_rate,
+           summary->histogram.flush_count);
+}
+
+static void jm_symbols_print_size_classes(void) {
+    int count = 0;
+
+    for (int i = 0; i < MAX_SIZE_CLASS_COUNT; i++)
+        if (summary->classes[i].alloc_count > 0) count++;
+
+    if (count == 0) return;
+
+    printf("SIZE CLASSES: \n");
+
+    for (int i = 0; i < MAX_SIZE_CLASS_COUNT; i++) {
+        const struct jmSizeClass_ *class = &summary->classes[i];
+
+        if (class->alloc_count == 0) continue;
+
+        // NOTE: The last class holds every size above `2^63`
+        if (i < MAX_SIZE_CLASS_COUNT - 1)
+            printf("  <= %-12ju : ", (uintmax_t) 1 << i);
+        else
+            printf("  >  %-12s : ", "2^63");
+
+        printf("%ld allocs, %ld bytes requested, %ld bytes of slack\n",
+               class->alloc_count,
+               class->req_total,
+               class->total - class->req_total);
+    }
+
+    printf("\n");
+}
@@ -26,158 +26,670 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include <dirent.h>
 #include <fcntl.h>
+#include <getopt.h>
 #include <linux/hw_breakpoint.h>
 #include <linux/perf_event.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/syscall.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <perfmon/pfmlib.h>
 #include <perfmon/pfmlib_perf_event.h>
 
+#include "uthash.h"
+
 #include "jmprof.h"
 
 /* Typedefs ===============================================================> */
 
 typedef struct jmEventCounter_ {
-    int fd;
-    uint64_t id;
     char name[MAX_BUFFER_SIZE];
+    int group;
+    struct jmEventCounterStats_ {
+        uint64_t sample_count, lost_count, throttle_count;
+    } stats;
+    struct jmEventCounterTotals_ {
+        uint64_t value, time_enabled, time_running;
+    } totals;
 } jmEventCounter;
 
+typedef struct jmEventDescriptor_ {
+    uint64_t key;
+    int fd, counter;
+    UT_hash_handle hh;
+} jmEventDescriptor;
+
+typedef struct jmSoftwareEvent_ {
+    const char *name;
+    uint64_t config, sample_period;
+} jmSoftwareEvent;
+
+typedef struct jmEventBuffer_ {
+    int fd, node;
+    struct perf_event_mmap_page *metadata;
+} jmEventBuffer;
+
 /*
-    NOTE: If a struct defines at least one named member, it is allowed to 
-    additionally declare its last member with incomplete array type. 
-    
-    When an element of the flexible array member is accessed (in an 
-    expression that uses operator `.` or `->` with the flexible array member's
-    name as the right-hand-side operand), then the struct behaves as if 
-    the array member had the longest size fitting in the memory allocated 
-    for this object. (since C99)
-
-    - https://en.cppreference.com/w/c/language/struct
+    NOTE: What `read()` returns for an event that is not in a group (or 
+    without `PERF_FORMAT_GROUP`), with the enabled and running times.
 */
 
 typedef struct jmEventReadFormat_ {
-    uint64_t event_count;
-    uint64_t time_running;
-    struct {
-        uint64_t value, id;
-    } events[];
+    uint64_t value;
+    uint64_t time_enabled, time_running;
+    uint64_t id;
 } jmEventReadFormat;
 
-/* Private Variables ======================================================> */
+/* Constants ==============================================================> */
+
+// NOTE: A prime period keeps the samples from following the loops in lockstep
+const uint64_t default_sample_period = 10007;
+
+// NOTE: Number of data pages in each ring buffer (must be a power of two)
+const size_t ring_buffer_page_count = 64;
+
+// NOTE: Comma-separated list of events in libpfm4 syntax
+const char *default_events = "LLC_MISSES:u,MEM_LOAD_RETIRED:L3_MISS:u";
+
+// NOTE: Sampled instead of the default events if the PMU is not available
+const char *fallback_events = "page-faults,minor-faults,major-faults,"
+                              "cpu-clock,task-clock";
 
-static jmEventCounter counters[] = {
-    { .fd = -1, .name = "LLC_MISSES:u" },
-    { .fd = -1, .name = "MEM_LOAD_RETIRED:L3_MISS:u" },
+/*
+    NOTE: Software events are counted by the kernel itself, and have
+    a default sampling period of their own. A page fault is already an
+    expensive trap into the kernel, so each one of them is sampled (with
+    the faulting address), while the clocks are sampled every millisecond.
+*/
+
+const jmSoftwareEvent software_events[] = {
+    { "page-faults", PERF_COUNT_SW_PAGE_FAULTS, 1 },
+    { "minor-faults", PERF_COUNT_SW_PAGE_FAULTS_MIN, 1 },
+    { "major-faults", PERF_COUNT_SW_PAGE_FAULTS_MAJ, 1 },
+    { "cpu-clock", PERF_COUNT_SW_CPU_CLOCK, 1000000 },
+    { "task-clock", PERF_COUNT_SW_TASK_CLOCK, 1000000 },
 };
 
+/* Private Variables ======================================================> */
+
+static size_t page_size = 4096;
+
+static uint64_t sample_period = default_sample_period;
+
+static bool is_period_set = false;
+
+/* ========================================================================> */
+
+static FILE *sample_fp;
+
+static volatile sig_atomic_t is_interrupted = 0;
+
+/* ========================================================================> */
+
+static pid_t target_pid = -1;
+
+static bool is_launched = false;
+
+/* ========================================================================> */
+
+static jmEventCounter counters[MAX_COUNTER_COUNT];
+
+static int counter_count, group_count;
+
+static jmEventDescriptor *descriptors;
+
+static jmEventBuffer *buffers;
+
+static int buffer_count;
+
+/* ========================================================================> */
+
+static jmSample pending[MAX_PENDING_COUNT];
+
+static int pending_count;
+
+static int node_count = 1;
+
+static bool is_querying_nodes = false;
+
 /* Private Function Prototypes ============================================> */
 
-static bool jm_perfmon_init(void);
+static bool jm_perfmon_init(const pid_t *tasks, int task_count);
 static bool jm_perfmon_deinit(void);
 
+static bool jm_perfmon_add_events(const char *str);
+static bool jm_perfmon_is_unsupported(int error);
+static int jm_perfmon_open_event(int counter, pid_t pid, int cpu, int group_fd);
+
+static pid_t jm_perfmon_launch(char *argv[], int *ready_fd);
+static int jm_perfmon_get_tasks(pid_t pid, pid_t **tasks);
+static bool jm_perfmon_is_alive(int *status);
+
 static void jm_perfmon_read_events(void);
+static void jm_perfmon_read_totals(void);
+static void jm_perfmon_read_record(const struct perf_event_header *header,
+                                   int cpu);
+static void jm_perfmon_write_sample(const jmSample *sample);
+static void jm_perfmon_flush_samples(void);
+static void jm_perfmon_query_nodes(jmSample *samples, int count);
+static void jm_perfmon_write_header(void);
+static void jm_perfmon_interrupt(int signum);
+
+static int jm_perfmon_get_node_count(void);
+static int jm_perfmon_get_cpu_node(int cpu);
 
-static void jm_perfmon_get_event_attr(const char *str,
+static const char *jm_perfmon_strerror(int error);
+
+static bool jm_perfmon_get_event_attr(const char *str,
                                       struct perf_event_attr *attr);
 
 /* Public Functions =======================================================> */
 
 int main(int argc, char *argv[]) {
-    if (!jm_perfmon_init()) {
-        char buffer[MAX_BUFFER_SIZE] = "";
+    const char *output_path = "jmprof-pm.data";
+
+    bool is_invalid = false;
+
+    int opt;
+
+    // NOTE: The options of the program to launch are not our own
+    while ((opt = getopt(argc, argv, "+c:e:o:p:")) != -1) {
+        switch (opt) {
+            case 'c':
+                sample_period = strtoull(optarg, NULL, 10);
+
+                if (sample_period == 0) sample_period = default_sample_period;
+
+                is_period_set = true;
+
+                break;
+
+            case 'e':
+                if (!jm_perfmon_add_events(optarg)) {
+                    fprintf(stderr,
+                            "%s: error: too many events (at most %d)\n",
+                            argv[0],
+                            MAX_COUNTER_COUNT);
+
+                    return 1;
+                }
+
+                break;
+
+            case 'o':
+                output_path = optarg;
+
+                break;
+
+            case 'p':
+                target_pid = atoi(optarg);
+
+                break;
+
+            default:
+                is_invalid = true;
+
+                break;
+        }
+    }
+
+    // NOTE: Exactly one of a process ID and a program must be given
+    if (is_invalid || ((target_pid > 0) == (optind < argc))) {
+        fprintf(stderr,
+                "%s: usage: %s [-c <period>] [-e <events>] [-o <path>] "
+                "(-p <pid> | <program> [<args>...])\n",
+                argv[0],
+                argv[0]);
+
+        return 1;
+    }
+
+    bool is_default = (counter_count == 0);
+
+    if (is_default) (void) jm_perfmon_add_events(default_events);
+
+    page_size = sysconf(_SC_PAGESIZE);
+
+    // NOTE: Every page is on the same node if there is only one
+    node_count = jm_perfmon_get_node_count();
+
+    is_querying_nodes = (node_count > 1);
+
+    sample_fp = fopen(output_path, "wb");
+
+    if (sample_fp == NULL) {
+        fprintf(stderr,
+                "%s: error: unable to open file '%s'\n",
+                argv[0],
+                output_path);
+
+        return 1;
+    }
+
+    int ready_fd = -1;
+
+    if (target_pid <= 0) {
+        target_pid = jm_perfmon_launch(argv + optind, &ready_fd);
+
+        is_launched = (target_pid > 0);
+    }
+
+    // NOTE: The threads that already exist must be measured one by one
+    pid_t *tasks = NULL;
+
+    int task_count = jm_perfmon_get_tasks(target_pid, &tasks);
+
+    bool is_ready = (task_count > 0 && jm_perfmon_init(tasks, task_count));
+
+    /*
+        NOTE: Virtual machines and containers often have no PMU that 
+        can be used, so the software events are sampled instead.
+    */
+
+    if (!is_ready && task_count > 0 && is_default
+        && jm_perfmon_is_unsupported(errno)) {
+        fprintf(stderr,
+                "%s: warning: unable to open the PMU events (%s), "
+                "falling back to software events\n",
+                argv[0],
+                jm_perfmon_strerror(errno));
 
-        (void) strncpy(buffer, strerror(errno), MAX_BUFFER_SIZE - 1);
+        (void) jm_perfmon_deinit();
 
-        for (char *c = buffer; *c != '\0' && (*c = tolower(*c)); ++c)
-            ;
+        (void) memset(counters, 0, sizeof counters);
 
+        counter_count = group_count = 0;
+
+        (void) jm_perfmon_add_events(fallback_events);
+
+        is_ready = jm_perfmon_init(tasks, task_count);
+    }
+
+    if (!is_ready) {
         fprintf(stderr,
                 "%s: error: jm_perfmon_init(): %s\n",
                 argv[0],
-                buffer);
+                jm_perfmon_strerror(errno));
+
+        (void) jm_perfmon_deinit();
+
+        // NOTE: The launched program exits without ever being executed
+        if (ready_fd >= 0) (void) close(ready_fd);
+
+        if (is_launched) (void) waitpid(target_pid, NULL, 0);
+
+        (void) fclose(sample_fp);
+
+        free(tasks);
 
         return 1;
     }
 
+    free(tasks);
+
+    jm_perfmon_write_header();
+
+    {
+        // NOTE: No `SA_RESTART`, so that `poll()` is interrupted
+        struct sigaction action = { .sa_handler = jm_perfmon_interrupt };
+
+        (void) sigaction(SIGINT, &action, NULL);
+        (void) sigaction(SIGTERM, &action, NULL);
+    }
+
+    // NOTE: The counters are enabled as soon as the program is executed
+    if (ready_fd >= 0) {
+        (void) write(ready_fd, "", 1);
+
+        (void) close(ready_fd);
+    }
+
+    int status = 0;
+
     {
-        // TODO: ...
+        struct pollfd *fds = calloc(buffer_count, sizeof(struct pollfd));
+
+        for (int i = 0; fds != NULL && i < buffer_count; i++)
+            fds[i] = (struct pollfd) { .fd = buffers[i].fd, .events = POLLIN };
+
+        while (!is_interrupted && jm_perfmon_is_alive(&status)) {
+            /*
+                NOTE: The kernel wakes us up once a ring buffer is half
+                full, but the buffers are also drained at least every 
+                100 milliseconds, so that the samples stay in order.
+            */
+
+            if (fds == NULL) (void) usleep(100000);
+            else if (poll(fds, buffer_count, 100) < 0 && errno != EINTR) break;
+
+            jm_perfmon_read_events();
+        }
+
+        jm_perfmon_read_events();
+
+        free(fds);
     }
 
+    jm_perfmon_read_totals();
+
     (void) jm_perfmon_deinit();
 
+    for (int i = 0; i < counter_count; i++) {
+        const struct jmEventCounterTotals_ *totals = &counters[i].totals;
+
+        fprintf(stderr,
+                "%s: %s (group %d): %" PRIu64 " samples, %" PRIu64
+                " lost, %" PRIu64 " throttled, %" PRIu64 " counted",
+                argv[0],
+                counters[i].name,
+                counters[i].group,
+                counters[i].stats.sample_count,
+                counters[i].stats.lost_count,
+                counters[i].stats.throttle_count,
+                totals->value);
+
+        // NOTE: A multiplexed event only counted for a part of the run
+        if (totals->time_running > 0
+            && totals->time_running < totals->time_enabled)
+            fprintf(stderr,
+                    " (~%.0f scaled, running %.2f%% of the time)",
+                    ((double) totals->value * totals->time_enabled)
+                        / totals->time_running,
+                    (100.0 * totals->time_running) / totals->time_enabled);
+
+        fprintf(stderr, "\n");
+    }
+
+    (void) fclose(sample_fp);
+
+    // NOTE: A launched program's exit status is passed on
+    if (is_launched && WIFEXITED(status)) return WEXITSTATUS(status);
+
     return 0;
 }
 
 /* Private Functions ======================================================> */
 
-static bool jm_perfmon_init(void) {
+static bool jm_perfmon_init(const pid_t *tasks, int task_count) {
     (void) pfm_initialize();
 
-    for (int i = 0, j = (sizeof counters / sizeof *counters); i < j; i++) {
-        struct perf_event_attr hw_event;
+    /*
+        NOTE: The ring buffer of an inherited event can only be mapped if 
+        the event is bound to a CPU, so every event is opened on each CPU.
+    */
 
-        // NOTE: "[pmu_name::]event_name[:unit_mask][:modifier|:modifier=val]"
-        jm_perfmon_get_event_attr(counters[i].name, &hw_event);
+    buffer_count = sysconf(_SC_NPROCESSORS_CONF);
 
-        /*
-            NOTE: glibc provides no wrapper for `perf_event_open()`,
-            necessitating the use of `syscall()`.
-        */
+    buffers = calloc(buffer_count, sizeof(jmEventBuffer));
 
-        int group_fd = (i > 0) ? counters[0].fd : -1;
+    if (buffers == NULL) return false;
 
-        counters[i]
-            .fd = syscall(SYS_perf_event_open,
-                          &hw_event,  // `struct perf_event_attr *hw_event`
-                          0,          // `pid_t pid`
-                          -1,         // `int cpu`
-                          group_fd,   // `int group_fd`
-                          PERF_FLAG_FD_CLOEXEC  // `unsigned long flags`
-        );
+    for (int cpu = 0; cpu < buffer_count; cpu++)
+        buffers[cpu].fd = -1, buffers[cpu].node = jm_perfmon_get_cpu_node(cpu);
 
-        if (counters[i].fd < 0) return false;
+    for (int cpu = 0; cpu < buffer_count; cpu++) {
+        for (int t = 0; t < task_count; t++) {
+            int group_fd = -1, group = 0;
 
-        (void) ioctl(counters[i].fd, PERF_EVENT_IOC_ID, &counters[i].id);
-    }
+            for (int i = 0; i < counter_count; i++) {
+                int fd = jm_perfmon_open_event(i, tasks[t], cpu, group_fd);
 
-    /* clang-format off */
+                /*
+                    NOTE: A CPU that is offline or a thread that has already
+                    exited cannot be measured, and is skipped as a whole.
+                */
 
-    (void) ioctl(counters[0].fd, 
-                    PERF_EVENT_IOC_RESET, 
-                    PERF_IOC_FLAG_GROUP);
+                if (fd < 0 && i == 0 && (errno == ENODEV || errno == ESRCH))
+                    break;
 
-    (void) ioctl(counters[0].fd,
-                    PERF_EVENT_IOC_ENABLE,
-                    PERF_IOC_FLAG_GROUP);
+                /*
+                    NOTE: A group is only accepted if the PMU can schedule
+                    all of its events at once, so an event that does not
+                    fit starts a new group. The kernel multiplexes the 
+                    groups when there are not enough hardware counters.
+                */
 
-    /* clang-format on */
+                if (fd < 0 && group_fd >= 0
+                    && (errno == EINVAL || errno == ENOSPC)) {
+                    group_fd = -1, group++;
 
-    return true;
+                    fd = jm_perfmon_open_event(i, tasks[t], cpu, group_fd);
+                }
+
+                if (fd < 0) return false;
+
+                if (group_fd < 0) group_fd = fd;
+
+                counters[i].group = group;
+
+                if (group_count < group + 1) group_count = group + 1;
+
+                jmEventDescriptor *descriptor = calloc(
+                    1, sizeof(jmEventDescriptor));
+
+                if (descriptor == NULL) {
+                    (void) close(fd);
+
+                    return false;
+                }
+
+                descriptor->fd = fd, descriptor->counter = i;
+
+                (void) ioctl(fd, PERF_EVENT_IOC_ID, &descriptor->key);
+
+                HASH_ADD(hh, descriptors, key, sizeof(uint64_t), descriptor);
+
+                // NOTE: Every event on a CPU writes to the same ring buffer
+                if (buffers[cpu].fd >= 0) {
+                    if (ioctl(fd, PERF_EVENT_IOC_SET_OUTPUT, buffers[cpu].fd)
+                        < 0)
+                        return false;
+
+                    continue;
+                }
+
+                // NOTE: The first page holds the metadata of the ring buffer
+                void *metadata = mmap(NULL,
+                                      (1 + ring_buffer_page_count) * page_size,
+                                      PROT_READ | PROT_WRITE,
+                                      MAP_SHARED,
+                                      fd,
+                                      0);
+
+                if (metadata == MAP_FAILED) return false;
+
+                buffers[cpu].fd = fd, buffers[cpu].metadata = metadata;
+            }
+        }
+    }
+
+    return (descriptors != NULL);
 }
 
 static bool jm_perfmon_deinit(void) {
     pfm_terminate();
 
-    for (int i = 0, j = (sizeof counters / sizeof *counters); i < j; i++) {
-        if (fcntl(counters[i].fd, F_GETFD) < 0) continue;
+    for (int i = 0; buffers != NULL && i < buffer_count; i++) {
+        if (buffers[i].metadata == NULL) continue;
+
+        (void) munmap(buffers[i].metadata,
+                      (1 + ring_buffer_page_count) * page_size);
+    }
+
+    free(buffers);
+
+    buffers = NULL, buffer_count = 0;
+
+    bool result = true;
 
-        (void) ioctl(counters[i].fd,
-                     PERF_EVENT_IOC_DISABLE,
-                     PERF_IOC_FLAG_GROUP);
+    jmEventDescriptor *descriptor = NULL, *temp = NULL;
 
-        if (close(counters[i].fd) < 0) return false;
+    HASH_ITER(hh, descriptors, descriptor, temp) {
+        (void) ioctl(descriptor->fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        if (close(descriptor->fd) < 0) result = false;
+
+        HASH_DEL(descriptors, descriptor);
+
+        free(descriptor);
+    }
+
+    return result;
+}
+
+static bool jm_perfmon_add_events(const char *str) {
+    for (const char *c = str; *c != '\0';) {
+        size_t length = strcspn(c, ",");
+
+        if (length > 0) {
+            if (counter_count >= MAX_COUNTER_COUNT) return false;
+
+            if (length >= MAX_BUFFER_SIZE) length = MAX_BUFFER_SIZE - 1;
+
+            (void) memcpy(counters[counter_count].name, c, length);
+
+            counters[counter_count++].name[length] = '\0';
+        }
+
+        c += strcspn(c, ",");
+
+        if (*c == ',') c++;
     }
 
     return true;
 }
 
+static bool jm_perfmon_is_unsupported(int error) {
+    // NOTE: The event is unknown to `libpfm4` or to the kernel
+    return (error == ENOENT || error == ENODEV || error == EOPNOTSUPP
+            || error == EINVAL);
+}
+
+static int jm_perfmon_open_event(int counter,
+                                 pid_t pid,
+                                 int cpu,
+                                 int group_fd) {
+    struct perf_event_attr hw_event = { .size = sizeof(hw_event) };
+
+    // NOTE: "[pmu_name::]event_name[:unit_mask][:modifier|:modifier=val]"
+    if (!jm_perfmon_get_event_attr(counters[counter].name, &hw_event)) {
+        // NOTE: See `jm_perfmon_is_unsupported()`
+        errno = ENOENT;
+
+        return -1;
+    }
+
+    // NOTE: Threads and processes created later are measured too
+    hw_event.inherit = 1;
+
+    // NOTE: A launched program is measured from its first instruction
+    if (is_launched) hw_event.disabled = 1, hw_event.enable_on_exec = 1;
+
+    /*
+        NOTE: glibc provides no wrapper for `perf_event_open()`,
+        necessitating the use of `syscall()`.
+    */
+
+    return syscall(SYS_perf_event_open,
+                   &hw_event,            // `struct perf_event_attr *hw_event`
+                   pid,                  // `pid_t pid`
+                   cpu,                  // `int cpu`
+                   group_fd,             // `int group_fd`
+                   PERF_FLAG_FD_CLOEXEC  // `unsigned long flags`
+    );
+}
+
+/* ========================================================================> */
+
+static pid_t jm_perfmon_launch(char *argv[], int *ready_fd) {
+    int fds[2];
+
+    if (pipe2(fds, O_CLOEXEC) < 0) return -1;
+
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        (void) close(fds[0]);
+        (void) close(fds[1]);
+
+        return -1;
+    }
+
+    if (pid == 0) {
+        char c;
+
+        (void) close(fds[1]);
+
+        // NOTE: The program must not start before the counters are opened
+        if (read(fds[0], &c, 1) != 1) _exit(1);
+
+        (void) execvp(argv[0], argv);
+
+        fprintf(stderr,
+                "jmprof-pm: error: unable to execute '%s'\n",
+                argv[0]);
+
+        _exit(127);
+    }
+
+    (void) close(fds[0]);
+
+    *ready_fd = fds[1];
+
+    return pid;
+}
+
+static int jm_perfmon_get_tasks(pid_t pid, pid_t **tasks) {
+    char path[MAX_BUFFER_SIZE];
+
+    (void) snprintf(path, sizeof path, "/proc/%d/task", pid);
+
+    DIR *dir = opendir(path);
+
+    if (dir == NULL) return -1;
+
+    int count = 0, capacity = 0;
+
+    for (struct dirent *entry; (entry = readdir(dir)) != NULL;) {
+        if (!isdigit(entry->d_name[0])) continue;
+
+        if (count == capacity) {
+            capacity = (capacity > 0) ? 2 * capacity : 16;
+
+            pid_t *buffer = realloc(*tasks, capacity * sizeof(pid_t));
+
+            if (buffer == NULL) break;
+
+            *tasks = buffer;
+        }
+
+        (*tasks)[count++] = atoi(entry->d_name);
+    }
+
+    (void) closedir(dir);
+
+    return count;
+}
+
+static bool jm_perfmon_is_alive(int *status) {
+    if (is_launched) return (waitpid(target_pid, status, WNOHANG) == 0);
+
+    return (kill(target_pid, 0) == 0 || errno != ESRCH);
+}
+
+/* ========================================================================> */
+
 static void jm_perfmon_read_events(void) {
     /*
         NOTE: Events come in two flavors: counting and sampled. 
@@ -190,25 +702,378 @@ static void jm_perfmon_read_events(void) {
         that can then be accessed via `mmap()`.
     */
 
-    // TODO: ...
+    const uint64_t size = ring_buffer_page_count * page_size;
+
+    for (int i = 0; i < buffer_count; i++) {
+        struct perf_event_mmap_page *metadata = buffers[i].metadata;
+
+        if (metadata == NULL) continue;
+
+        unsigned char *data = (unsigned char *) metadata + page_size;
+
+        // NOTE: The records must not be read before `data_head` is
+        uint64_t head = __atomic_load_n(&metadata->data_head, __ATOMIC_ACQUIRE);
+        uint64_t tail = metadata->data_tail;
+
+        while (tail < head) {
+            uint64_t offset = tail & (size - 1);
+
+            const struct perf_event_header *header =
+                (const struct perf_event_header *) (data + offset);
+
+            size_t record_size = header->size;
+
+            if (record_size == 0) {
+                tail = head;
+
+                break;
+            }
+
+            /*
+                NOTE: A record that wraps around the end of the ring buffer
+                is copied out, so that it can be read in one piece.
+            */
+
+            uint64_t record[MAX_BUFFER_SIZE / sizeof(uint64_t)];
+
+            if (offset + record_size > size) {
+                size_t length = size - offset;
+
+                if (record_size > sizeof record) {
+                    tail += record_size;
+
+                    continue;
+                }
+
+                (void) memcpy(record, data + offset, length);
+                (void) memcpy((unsigned char *) record + length,
+                              data,
+                              record_size - length);
+
+                header = (const struct perf_event_header *) record;
+            }
+
+            jm_perfmon_read_record(header, i);
+
+            tail += record_size;
+        }
+
+        // NOTE: The kernel may overwrite the records once `data_tail` moves
+        __atomic_store_n(&metadata->data_tail, tail, __ATOMIC_RELEASE);
+    }
+
+    jm_perfmon_flush_samples();
 }
 
-static void jm_perfmon_get_event_attr(const char *str,
+static void jm_perfmon_read_totals(void) {
+    jmEventDescriptor *descriptor = NULL, *temp = NULL;
+
+    /*
+        NOTE: The values of the events inherited by other threads and 
+        processes are added to those of their parents once they exit.
+    */
+
+    HASH_ITER(hh, descriptors, descriptor, temp) {
+        jmEventReadFormat format;
+
+        if (read(descriptor->fd, &format, sizeof format) != sizeof format)
+            continue;
+
+        struct jmEventCounterTotals_ *totals =
+            &counters[descriptor->counter].totals;
+
+        totals->value += format.value;
+        totals->time_enabled += format.time_enabled;
+        totals->time_running += format.time_running;
+    }
+
+    for (int i = 0; i < counter_count; i++) {
+        const struct jmEventCounterTotals_ *totals = &counters[i].totals;
+
+        jmSample sample = { .kind = JM_SAMPLE_KIND_TOTAL,
+                            .counter = i,
+                            .addr = totals->time_enabled,
+                            .phys_addr = totals->time_running,
+                            .weight = totals->value };
+
+        (void) fwrite(&sample, sizeof sample, 1, sample_fp);
+    }
+}
+
+static void jm_perfmon_read_record(const struct perf_event_header *header,
+                                   int cpu) {
+    const uint64_t *values = (const uint64_t *) (header + 1);
+
+    jmSample sample = { .kind = JM_SAMPLE_KIND_COUNT,
+                        .node = -1,
+                        .cpu_node = buffers[cpu].node };
+
+    uint64_t id = 0;
+
+    switch (header->type) {
+        case PERF_RECORD_SAMPLE:
+            // NOTE: The fields are in the same order as `PERF_SAMPLE_*` bits
+            sample.kind = JM_SAMPLE_KIND_SAMPLE;
+
+            id = *values++;
+
+            sample.ip = *values++;
+
+            {
+                const uint32_t *ids = (const uint32_t *) values++;
+
+                sample.pid = ids[0], sample.tid = ids[1];
+            }
+
+            sample.timestamp = *values++;
+            sample.addr = *values++;
+            sample.weight = *values++;
+
+            break;
+
+        case PERF_RECORD_LOST:
+            // `<ID> <LOST>`
+            sample.kind = JM_SAMPLE_KIND_LOST;
+
+            id = values[0], sample.weight = values[1];
+
+            break;
+
+        case PERF_RECORD_THROTTLE:
+        case PERF_RECORD_UNTHROTTLE:
+            // `<TIMESTAMP> <ID> <STREAM_ID>`
+            sample.kind = (header->type == PERF_RECORD_THROTTLE)
+                              ? JM_SAMPLE_KIND_THROTTLE
+                              : JM_SAMPLE_KIND_UNTHROTTLE;
+
+            sample.timestamp = values[0], id = values[1];
+
+            break;
+
+        default:
+            return;
+    }
+
+    // NOTE: An inherited event reports the ID of the event we opened
+    jmEventDescriptor *descriptor = NULL;
+
+    HASH_FIND(hh, descriptors, &id, sizeof(uint64_t), descriptor);
+
+    if (descriptor == NULL) return;
+
+    sample.counter = descriptor->counter;
+
+    struct jmEventCounterStats_ *stats = &counters[sample.counter].stats;
+
+    if (sample.kind == JM_SAMPLE_KIND_SAMPLE) stats->sample_count++;
+    if (sample.kind == JM_SAMPLE_KIND_LOST) stats->lost_count += sample.weight;
+    if (sample.kind == JM_SAMPLE_KIND_THROTTLE) stats->throttle_count++;
+
+    jm_perfmon_write_sample(&sample);
+}
+
+static void jm_perfmon_write_sample(const jmSample *sample) {
+    if (pending_count == MAX_PENDING_COUNT) jm_perfmon_flush_samples();
+
+    pending[pending_count++] = *sample;
+}
+
+static void jm_perfmon_flush_samples(void) {
+    if (pending_count == 0) return;
+
+    jm_perfmon_query_nodes(pending, pending_count);
+
+    (void) fwrite(pending, sizeof(jmSample), pending_count, sample_fp);
+
+    pending_count = 0;
+}
+
+static void jm_perfmon_query_nodes(jmSample *samples, int count) {
+    if (node_count <= 1) {
+        for (int i = 0; i < count; i++)
+            if (samples[i].addr != 0) samples[i].node = 0;
+
+        return;
+    }
+
+    if (!is_querying_nodes) return;
+
+    void *pages[MAX_PENDING_COUNT];
+
+    int indexes[MAX_PENDING_COUNT], status[MAX_PENDING_COUNT];
+
+    /*
+        NOTE: `move_pages()` without a list of nodes only tells where the 
+        pages are, for one process at a time. The samples are a fraction
+        of a second old by now, so the pages of a block that has been 
+        freed in the meantime are not found.
+    */
+
+    for (int i = 0, j = 0; i < count; i = j) {
+        int page_count = 0;
+
+        for (j = i; j < count && samples[j].pid == samples[i].pid; j++) {
+            if (samples[j].kind != JM_SAMPLE_KIND_SAMPLE
+                || samples[j].addr == 0)
+                continue;
+
+            pages[page_count] = (void *) (uintptr_t) (samples[j].addr
+                                                      & ~(page_size - 1));
+
+            indexes[page_count++] = j;
+        }
+
+        if (page_count == 0) continue;
+
+        if (syscall(SYS_move_pages,
+                    samples[i].pid,
+                    page_count,
+                    pages,
+                    NULL,
+                    status,
+                    0)
+            < 0) {
+            if (errno == EPERM || errno == ENOSYS) {
+                fprintf(stderr,
+                        "%s: warning: unable to query the nodes of the "
+                        "sampled pages (%s)\n",
+                        program_invocation_name,
+                        jm_perfmon_strerror(errno));
+
+                is_querying_nodes = false;
+
+                return;
+            }
+
+            continue;
+        }
+
+        // NOTE: A negative status is an error code for that page
+        for (int k = 0; k < page_count; k++)
+            if (status[k] >= 0) samples[indexes[k]].node = status[k];
+    }
+}
+
+static void jm_perfmon_write_header(void) {
+    jmSampleHeader header = {
+        .version = SAMPLE_FILE_VERSION,
+        .counter_count = counter_count
+    };
+
+    (void) memcpy(header.magic, SAMPLE_FILE_MAGIC, sizeof header.magic);
+
+    (void) fwrite(&header, sizeof header, 1, sample_fp);
+
+    for (int i = 0; i < counter_count; i++)
+        (void) fwrite(counters[i].name, MAX_BUFFER_SIZE, 1, sample_fp);
+}
+
+static void jm_perfmon_interrupt(int signum) {
+    (void) signum;
+
+    is_interrupted = 1;
+}
+
+static const char *jm_perfmon_strerror(int error) {
+    static char buffer[MAX_BUFFER_SIZE];
+
+    (void) strncpy(buffer, strerror(error), MAX_BUFFER_SIZE - 1);
+
+    for (char *c = buffer; *c != '\0' && (*c = tolower(*c)); ++c)
+        ;
+
+    return buffer;
+}
+
+static int jm_perfmon_get_node_count(void) {
+    DIR *dir = opendir("/sys/devices/system/node");
+
+    // NOTE: A kernel built without NUMA support has no such directory
+    if (dir == NULL) return 1;
+
+    int result = 0;
+
+    struct dirent *entry = NULL;
+
+    while ((entry = readdir(dir)) != NULL) {
+        int node = 0;
+
+        if (sscanf(entry->d_name, "node%d", &node) == 1) result++;
+    }
+
+    (void) closedir(dir);
+
+    return (result > 0) ? result : 1;
+}
+
+static int jm_perfmon_get_cpu_node(int cpu) {
+    char path[MAX_BUFFER_SIZE];
+
+    (void) snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d", cpu);
+
+    DIR *dir = opendir(path);
+
+    if (dir == NULL) return 0;
+
+    int result = 0;
+
+    struct dirent *entry = NULL;
+
+    // NOTE: `cpu<N>/node<M>` is a link to the node that CPU belongs to
+    while ((entry = readdir(dir)) != NULL)
+        if (sscanf(entry->d_name, "node%d", &result) == 1) break;
+
+    (void) closedir(dir);
+
+    return result;
+}
+
+static bool jm_perfmon_get_event_attr(const char *str,
                                       struct perf_event_attr *attr) {
-    if (str == NULL || attr == NULL) return;
+    if (str == NULL || attr == NULL) return false;
 
-    attr->type = PERF_TYPE_MAX;
+    /*
+        NOTE: `hw_event` must be zero-initialized, except for the `size` 
+        field. `PERF_FORMAT_GROUP` cannot be combined with `inherit`, and 
+        `PERF_SAMPLE_IDENTIFIER` tells the events sharing a buffer apart.
+        The enabled and running times are needed to scale the values of 
+        events that were multiplexed. `PERF_SAMPLE_PHYS_ADDR` is never
+        requested, since it needs privileges that containers lack (and
+        the placement of a page is found with `move_pages()` instead).
+    */
 
-    // NOTE: `hw_event` must be zero-initialized, except for the `size` field
     struct perf_event_attr hw_event = {
         .size = sizeof(hw_event),
-        .sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_TIME | PERF_SAMPLE_ADDR
-                       | PERF_SAMPLE_WEIGHT | PERF_SAMPLE_PHYS_ADDR,
-        .read_format = PERF_FORMAT_ID | PERF_FORMAT_GROUP,
+        .sample_period = sample_period,
+        .sample_type = PERF_SAMPLE_IDENTIFIER | PERF_SAMPLE_IP
+                       | PERF_SAMPLE_TID | PERF_SAMPLE_TIME | PERF_SAMPLE_ADDR
+                       | PERF_SAMPLE_WEIGHT,
+        .read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                       | PERF_FORMAT_TOTAL_TIME_RUNNING | PERF_FORMAT_ID,
         .exclude_hv = 1,
-        .exclude_kernel = 1
+        .exclude_kernel = 1,
+        .watermark = 1,
+        .wakeup_watermark = (ring_buffer_page_count * page_size) / 2,
+        .use_clockid = 1,
+        .clockid = CLOCK_MONOTONIC
     };
 
+    for (int i = 0, j = (sizeof software_events / sizeof *software_events);
+         i < j;
+         i++) {
+        if (strcmp(str, software_events[i].name) != 0) continue;
+
+        hw_event.type = PERF_TYPE_SOFTWARE;
+        hw_event.config = software_events[i].config;
+
+        if (!is_period_set)
+            hw_event.sample_period = software_events[i].sample_period;
+
+        *attr = hw_event;
+
+        return true;
+    }
+
     pfm_perf_encode_arg_t arg = { .attr = &hw_event,
                                   .size = sizeof(pfm_perf_encode_arg_t) };
 
@@ -222,7 +1087,9 @@ static void jm_perfmon_get_event_attr(const char *str,
                                               PFM_OS_PERF_EVENT_EXT,
                                               &arg);
 
-    if (ret != PFM_SUCCESS) return;
+    if (ret != PFM_SUCCESS) return false;
 
     *attr = hw_event;
-}
\ No newline at end of file
+
+    return true;
+}
@@ -24,10 +24,14 @@
 
 #define _GNU_SOURCE
 
+#include <stdarg.h>
 #include <stddef.h>
 #include <stdlib.h>
 
 #include <dlfcn.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
 #include <unistd.h>
 
 #define SOKOL_TIME_IMPL
@@ -41,21 +45,67 @@ typedef void *(jm_libc_calloc_t) (size_t num, size_t size);
 typedef void *(jm_libc_malloc_t) (size_t size);
 typedef void *(jm_libc_realloc_t) (void *ptr, size_t new_size);
 
+typedef void *(jm_libc_aligned_alloc_t) (size_t alignment, size_t size);
+typedef void *(jm_libc_memalign_t) (size_t alignment, size_t size);
+typedef int(jm_libc_posix_memalign_t)(void **memptr,
+                                      size_t alignment,
+                                      size_t size);
+typedef void *(jm_libc_pvalloc_t) (size_t size);
+typedef void *(jm_libc_reallocarray_t) (void *ptr, size_t num, size_t size);
+typedef void *(jm_libc_valloc_t) (size_t size);
+
 typedef void(jm_libc_free_t)(void *ptr);
 
-/* TODO: `aligned_alloc()`, `posix_memalign()`, `sbrk()`, `mmap()`, etc. */
+typedef void (*(jm_libcxx_get_new_handler_t) (void))(void);
+
+typedef void *(jm_libc_mmap_t) (void *addr,
+                                size_t length,
+                                int prot,
+                                int flags,
+                                int fd,
+                                off_t offset);
+typedef int(jm_libc_munmap_t)(void *addr, size_t length);
+typedef void *(jm_libc_mremap_t) (void *old_address,
+                                  size_t old_size,
+                                  size_t new_size,
+                                  int flags,
+                                  ...);
+
+typedef int(jm_libc_brk_t)(void *addr);
+typedef void *(jm_libc_sbrk_t) (intptr_t increment);
 
 typedef void *(jm_libc_dlopen) (const char *file, int mode);
 typedef int(jm_libc_dlclose)(void *handle);
 
+typedef int(jm_libc_pthread_setname_np)(pthread_t thread, const char *name);
+typedef int(jm_libc_prctl)(int option, ...);
+
 /* Private Variables ======================================================> */
 
 static jm_libc_calloc_t *libc_calloc;
 static jm_libc_malloc_t *libc_malloc;
 static jm_libc_realloc_t *libc_realloc;
 
+static jm_libc_aligned_alloc_t *libc_aligned_alloc;
+static jm_libc_memalign_t *libc_memalign;
+static jm_libc_posix_memalign_t *libc_posix_memalign;
+static jm_libc_pvalloc_t *libc_pvalloc;
+static jm_libc_reallocarray_t *libc_reallocarray;
+static jm_libc_valloc_t *libc_valloc;
+
 static jm_libc_free_t *libc_free;
 
+static jm_libcxx_get_new_handler_t *libcxx_get_new_handler;
+
+/* ========================================================================> */
+
+static jm_libc_mmap_t *libc_mmap;
+static jm_libc_munmap_t *libc_munmap;
+static jm_libc_mremap_t *libc_mremap;
+
+static jm_libc_brk_t *libc_brk;
+static jm_libc_sbrk_t *libc_sbrk;
+
 /* ========================================================================> */
 
 static jm_libc_dlopen *libc_dlopen;
@@ -63,6 +113,11 @@ static jm_libc_dlclose *libc_dlclose;
 
 /* ========================================================================> */
 
+static jm_libc_pthread_setname_np *libc_pthread_setname_np;
+static jm_libc_prctl *libc_prctl;
+
+/* ========================================================================> */
+
 static pthread_once_t preload_init_once = PTHREAD_ONCE_INIT;
 static pthread_once_t preload_deinit_once = PTHREAD_ONCE_INIT;
 
@@ -72,10 +127,31 @@ static pthread_key_t calloc_key;
 static pthread_key_t malloc_key;
 static pthread_key_t realloc_key;
 
+static pthread_key_t aligned_alloc_key;
+static pthread_key_t memalign_key;
+static pthread_key_t posix_memalign_key;
+static pthread_key_t pvalloc_key;
+static pthread_key_t reallocarray_key;
+static pthread_key_t valloc_key;
+
 static pthread_key_t free_key;
 
 /* ========================================================================> */
 
+static pthread_key_t new_key;
+static pthread_key_t delete_key;
+
+/* ========================================================================> */
+
+static pthread_key_t mmap_key;
+static pthread_key_t munmap_key;
+static pthread_key_t mremap_key;
+
+static pthread_key_t brk_key;
+static pthread_key_t sbrk_key;
+
+/* ========================================================================> */
+
 static bool is_initialized = true;
 
 /* Private Function Prototypes ============================================> */
@@ -83,6 +159,9 @@ static bool is_initialized = true;
 static void jm_preload_init_(void);
 static void jm_preload_deinit_(void);
 
+static bool jm_preload_is_tracked(pthread_key_t key);
+static inline bool jm_preload_count(jmEvent event);
+
 /* ========================================================================> */
 
 static void jm_preload_atfork_prepare(void);
@@ -100,6 +179,24 @@ static void jm_preload_malloc_deinit(void);
 static void jm_preload_realloc_init(void);
 static void jm_preload_realloc_deinit(void);
 
+static void jm_preload_aligned_alloc_init(void);
+static void jm_preload_aligned_alloc_deinit(void);
+
+static void jm_preload_memalign_init(void);
+static void jm_preload_memalign_deinit(void);
+
+static void jm_preload_posix_memalign_init(void);
+static void jm_preload_posix_memalign_deinit(void);
+
+static void jm_preload_pvalloc_init(void);
+static void jm_preload_pvalloc_deinit(void);
+
+static void jm_preload_reallocarray_init(void);
+static void jm_preload_reallocarray_deinit(void);
+
+static void jm_preload_valloc_init(void);
+static void jm_preload_valloc_deinit(void);
+
 /* ========================================================================> */
 
 static void jm_preload_free_init(void);
@@ -107,12 +204,53 @@ static void jm_preload_free_deinit(void);
 
 /* ========================================================================> */
 
+static void *jm_preload_new(size_t size,
+                            size_t alignment,
+                            jmAllocKind kind,
+                            const char *name,
+                            bool is_nothrow,
+                            const void *caller);
+static void jm_preload_delete(void *ptr, size_t size, jmAllocKind kind);
+
+static void jm_preload_new_init(void);
+static void jm_preload_new_deinit(void);
+
+static void jm_preload_delete_init(void);
+static void jm_preload_delete_deinit(void);
+
+/* ========================================================================> */
+
+static void jm_preload_mmap_init(void);
+static void jm_preload_mmap_deinit(void);
+
+static void jm_preload_munmap_init(void);
+static void jm_preload_munmap_deinit(void);
+
+static void jm_preload_mremap_init(void);
+static void jm_preload_mremap_deinit(void);
+
+static void jm_preload_brk_init(void);
+static void jm_preload_brk_deinit(void);
+
+static void jm_preload_sbrk_init(void);
+static void jm_preload_sbrk_deinit(void);
+
+/* ========================================================================> */
+
 static void jm_preload_dlopen_init(void);
 static void jm_preload_dlopen_deinit(void);
 
 static void jm_preload_dlclose_init(void);
 static void jm_preload_dlclose_deinit(void);
 
+/* ========================================================================> */
+
+static void jm_preload_pthread_setname_np_init(void);
+static void jm_preload_pthread_setname_np_deinit(void);
+
+static void jm_preload_prctl_init(void);
+static void jm_preload_prctl_deinit(void);
+
 /* Public Functions =======================================================> */
 
 __attribute__((constructor))
@@ -120,12 +258,18 @@ void jm_preload_init(void) {
     pthread_once(&preload_init_once, jm_preload_init_);
 
     jm_tracker_init();
+    jm_control_init();
+    jm_filter_init();
+    jm_histogram_init();
 }
 
 __attribute__((destructor))
 void jm_preload_deinit(void) {
     pthread_once(&preload_deinit_once, jm_preload_deinit_);
 
+    jm_histogram_deinit();
+    jm_filter_deinit();
+    jm_control_deinit();
     jm_tracker_deinit();
 }
 
@@ -134,13 +278,27 @@ void jm_preload_deinit(void) {
 void *calloc(size_t num, size_t size) {
     if (libc_calloc == NULL) jm_preload_init();
 
+    uint64_t start = jm_tracker_get_ticks();
+
     void *result = libc_calloc(num, size);
 
-    if (is_initialized && (pthread_getspecific(calloc_key) == NULL)) {
+    uint64_t duration = jm_tracker_get_ticks() - start;
+
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_ALLOC,
+                                     .ptr = result,
+                                     .size = num * size }))
+        return result;
+
+    if (jm_preload_is_tracked(calloc_key)) {
         pthread_setspecific(calloc_key, &calloc_key);
 
         jm_tracker_update_mappings();
-        jm_backtrace_unwind(true, result, num * size);
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = JM_OPCODE_ALLOC,
+            .ptr = result,
+            .size = num * size,
+            .duration = duration,
+            .caller = __builtin_return_address(0) });
 
         pthread_setspecific(calloc_key, NULL);
     }
@@ -151,13 +309,27 @@ void *calloc(size_t num, size_t size) {
 void *malloc(size_t size) {
     if (libc_malloc == NULL) jm_preload_init();
 
+    uint64_t start = jm_tracker_get_ticks();
+
     void *result = libc_malloc(size);
 
-    if (is_initialized && (pthread_getspecific(malloc_key) == NULL)) {
+    uint64_t duration = jm_tracker_get_ticks() - start;
+
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_ALLOC,
+                                     .ptr = result,
+                                     .size = size }))
+        return result;
+
+    if (jm_preload_is_tracked(malloc_key)) {
         pthread_setspecific(malloc_key, &malloc_key);
 
         jm_tracker_update_mappings();
-        jm_backtrace_unwind(true, result, size);
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = JM_OPCODE_ALLOC,
+            .ptr = result,
+            .size = size,
+            .duration = duration,
+            .caller = __builtin_return_address(0) });
 
         pthread_setspecific(malloc_key, NULL);
     }
@@ -168,13 +340,51 @@ void *malloc(size_t size) {
 void *realloc(void *ptr, size_t new_size) {
     if (libc_realloc == NULL) jm_preload_init();
 
-    void *result = libc_realloc(ptr, new_size);
-    
-    if (is_initialized && (pthread_getspecific(realloc_key) == NULL)) {
+    bool is_tracked = jm_preload_is_tracked(realloc_key);
+
+    /*
+        NOTE: The size of the old block must be known before calling 
+        `realloc()`, since the block might be gone after the call.
+    */
+
+    size_t old_size = (is_tracked && (ptr != NULL)) ? malloc_usable_size(ptr)
+                                                    : 0;
+
+    // NOTE: See `jm_preload_count()`
+    if (is_tracked && jm_histogram_is_enabled()) {
+        void *result = libc_realloc(ptr, new_size);
+
+        if (result != NULL || new_size == 0)
+            jm_histogram_count((jmEvent) { .opcode = JM_OPCODE_REALLOC,
+                                           .ptr = result,
+                                           .old_ptr = ptr,
+                                           .size = new_size,
+                                           .old_size = old_size });
+
+        return result;
+    }
+
+    if (is_tracked) {
         pthread_setspecific(realloc_key, &realloc_key);
 
         jm_tracker_update_mappings();
+    }
+
+    // NOTE: The old block is released by the call, not after the event
+    bool is_locked = is_tracked && (ptr != NULL);
+
+    if (is_locked) jm_backtrace_lock();
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    void *result = libc_realloc(ptr, new_size);
+
+    uint64_t duration = jm_tracker_get_ticks() - start;
 
+    // NOTE: If `realloc()` fails, the original block is left untouched
+    bool has_failed = ((result == NULL) && (new_size > 0));
+
+    if (is_tracked && !has_failed) {
         /*
             NOTE: The description of `realloc()` has been modified from
             previous versions of this standard to align with the
@@ -187,11 +397,250 @@ void *realloc(void *ptr, size_t new_size) {
             indicated that this interpretation is incorrect.
         */
 
-        bool may_free = ((ptr != NULL) && (new_size == 0));
+        // NOTE: glibc frees `ptr` and returns a null pointer in that case
+
+        jm_backtrace_unwind((jmEvent) { .opcode = JM_OPCODE_REALLOC,
+                                        .ptr = result,
+                                        .old_ptr = ptr,
+                                        .size = new_size,
+                                        .old_size = old_size,
+                                        .duration = duration });
+    }
+
+    if (is_locked) jm_backtrace_unlock();
+
+    if (is_tracked) pthread_setspecific(realloc_key, NULL);
+
+    return result;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    if (libc_aligned_alloc == NULL) jm_preload_init();
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    void *result = libc_aligned_alloc(alignment, size);
+
+    uint64_t duration = jm_tracker_get_ticks() - start;
+
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_ALLOC,
+                                     .ptr = result,
+                                     .size = size }))
+        return result;
+
+    if (jm_preload_is_tracked(aligned_alloc_key)) {
+        pthread_setspecific(aligned_alloc_key, &aligned_alloc_key);
 
-        jm_backtrace_unwind(!may_free, result, new_size);
+        jm_tracker_update_mappings();
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = JM_OPCODE_ALLOC,
+            .ptr = result,
+            .size = size,
+            .duration = duration,
+            .caller = __builtin_return_address(0) });
+
+        pthread_setspecific(aligned_alloc_key, NULL);
+    }
+
+    return result;
+}
+
+void *memalign(size_t alignment, size_t size) {
+    if (libc_memalign == NULL) jm_preload_init();
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    void *result = libc_memalign(alignment, size);
 
-        pthread_setspecific(realloc_key, NULL);
+    uint64_t duration = jm_tracker_get_ticks() - start;
+
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_ALLOC,
+                                     .ptr = result,
+                                     .size = size }))
+        return result;
+
+    if (jm_preload_is_tracked(memalign_key)) {
+        pthread_setspecific(memalign_key, &memalign_key);
+
+        jm_tracker_update_mappings();
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = JM_OPCODE_ALLOC,
+            .ptr = result,
+            .size = size,
+            .duration = duration,
+            .caller = __builtin_return_address(0) });
+
+        pthread_setspecific(memalign_key, NULL);
+    }
+
+    return result;
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    if (libc_posix_memalign == NULL) jm_preload_init();
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    int result = libc_posix_memalign(memptr, alignment, size);
+
+    uint64_t duration = jm_tracker_get_ticks() - start;
+
+    // NOTE: `*memptr` is left unmodified if `posix_memalign()` fails
+    if (result != 0) return result;
+
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_ALLOC,
+                                     .ptr = *memptr,
+                                     .size = size }))
+        return result;
+
+    if (jm_preload_is_tracked(posix_memalign_key)) {
+        pthread_setspecific(posix_memalign_key, &posix_memalign_key);
+
+        jm_tracker_update_mappings();
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = JM_OPCODE_ALLOC,
+            .ptr = *memptr,
+            .size = size,
+            .duration = duration,
+            .caller = __builtin_return_address(0) });
+
+        pthread_setspecific(posix_memalign_key, NULL);
+    }
+
+    return result;
+}
+
+void *pvalloc(size_t size) {
+    if (libc_pvalloc == NULL) jm_preload_init();
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    void *result = libc_pvalloc(size);
+
+    uint64_t duration = jm_tracker_get_ticks() - start;
+
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_ALLOC,
+                                     .ptr = result,
+                                     .size = size }))
+        return result;
+
+    if (jm_preload_is_tracked(pvalloc_key)) {
+        pthread_setspecific(pvalloc_key, &pvalloc_key);
+
+        jm_tracker_update_mappings();
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = JM_OPCODE_ALLOC,
+            .ptr = result,
+            .size = size,
+            .duration = duration,
+            .caller = __builtin_return_address(0) });
+
+        pthread_setspecific(pvalloc_key, NULL);
+    }
+
+    return result;
+}
+
+void *reallocarray(void *ptr, size_t num, size_t size) {
+    if (libc_reallocarray == NULL) jm_preload_init();
+
+    bool is_tracked = jm_preload_is_tracked(reallocarray_key);
+
+    size_t old_size = (is_tracked && (ptr != NULL)) ? malloc_usable_size(ptr)
+                                                    : 0;
+
+    /*
+        NOTE: glibc implements `reallocarray()` on top of `realloc()`, 
+        so the inner call must not be recorded a second time.
+    */
+
+    void *realloc_guard = pthread_getspecific(realloc_key);
+
+    pthread_setspecific(realloc_key, &realloc_key);
+
+    // NOTE: See `jm_preload_count()`
+    if (is_tracked && jm_histogram_is_enabled()) {
+        void *result = libc_reallocarray(ptr, num, size);
+
+        pthread_setspecific(realloc_key, realloc_guard);
+
+        if (result != NULL || num == 0 || size == 0)
+            jm_histogram_count((jmEvent) { .opcode = JM_OPCODE_REALLOC,
+                                           .ptr = result,
+                                           .old_ptr = ptr,
+                                           .size = num * size,
+                                           .old_size = old_size });
+
+        return result;
+    }
+
+    if (is_tracked) {
+        pthread_setspecific(reallocarray_key, &reallocarray_key);
+
+        jm_tracker_update_mappings();
+    }
+
+    // NOTE: See `realloc()`
+    bool is_locked = is_tracked && (ptr != NULL);
+
+    if (is_locked) jm_backtrace_lock();
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    void *result = libc_reallocarray(ptr, num, size);
+
+    uint64_t duration = jm_tracker_get_ticks() - start;
+
+    pthread_setspecific(realloc_key, realloc_guard);
+
+    /*
+        NOTE: `reallocarray()` also fails (without modifying the original
+        block) if `num * size` overflows.
+    */
+
+    bool has_failed = ((result == NULL) && (num > 0) && (size > 0));
+
+    if (is_tracked && !has_failed)
+        jm_backtrace_unwind((jmEvent) { .opcode = JM_OPCODE_REALLOC,
+                                        .ptr = result,
+                                        .old_ptr = ptr,
+                                        .size = num * size,
+                                        .old_size = old_size,
+                                        .duration = duration });
+
+    if (is_locked) jm_backtrace_unlock();
+
+    if (is_tracked) pthread_setspecific(reallocarray_key, NULL);
+
+    return result;
+}
+
+void *valloc(size_t size) {
+    if (libc_valloc == NULL) jm_preload_init();
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    void *result = libc_valloc(size);
+
+    uint64_t duration = jm_tracker_get_ticks() - start;
+
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_ALLOC,
+                                     .ptr = result,
+                                     .size = size }))
+        return result;
+
+    if (jm_preload_is_tracked(valloc_key)) {
+        pthread_setspecific(valloc_key, &valloc_key);
+
+        jm_tracker_update_mappings();
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = JM_OPCODE_ALLOC,
+            .ptr = result,
+            .size = size,
+            .duration = duration,
+            .caller = __builtin_return_address(0) });
+
+        pthread_setspecific(valloc_key, NULL);
     }
 
     return result;
@@ -200,15 +649,376 @@ void *realloc(void *ptr, size_t new_size) {
 void free(void *ptr) {
     if (libc_free == NULL) jm_preload_init();
 
-    if (is_initialized && (pthread_getspecific(free_key) == NULL)) {
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_FREE, .ptr = ptr }))
+        return libc_free(ptr);
+
+    bool is_recorded = false;
+
+    if (jm_preload_is_tracked(free_key)) {
         pthread_setspecific(free_key, &free_key);
 
-        if (ptr != NULL) jm_backtrace_unwind(false, ptr, 0);
+        if (ptr != NULL)
+            is_recorded = jm_backtrace_unwind(
+                (jmEvent) { .opcode = JM_OPCODE_FREE, .ptr = ptr });
 
         pthread_setspecific(free_key, NULL);
     }
 
-    return libc_free(ptr);
+    if (!is_recorded || !jm_tracker_is_timing()) return libc_free(ptr);
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    libc_free(ptr);
+
+    jm_backtrace_time_free(ptr, jm_tracker_get_ticks() - start);
+}
+
+/* ========================================================================> */
+
+/*
+    NOTE: The C++ allocation and deallocation functions below are defined
+    with their Itanium C++ ABI (mangled) names, assuming that `size_t` is 
+    `unsigned long` and `std::align_val_t` is passed as a `size_t`.
+*/
+
+// `operator new(std::size_t)`
+void *_Znwm(size_t size) {
+    return jm_preload_new(size,
+                          0,
+                          JM_ALLOC_KIND_NEW,
+                          "_Znwm",
+                          false,
+                          __builtin_return_address(0));
+}
+
+// `operator new[](std::size_t)`
+void *_Znam(size_t size) {
+    return jm_preload_new(size,
+                          0,
+                          JM_ALLOC_KIND_NEW_ARRAY,
+                          "_Znam",
+                          false,
+                          __builtin_return_address(0));
+}
+
+// `operator new(std::size_t, const std::nothrow_t &)`
+void *_ZnwmRKSt9nothrow_t(size_t size, const void *tag) {
+    (void) tag;
+
+    return jm_preload_new(size,
+                          0,
+                          JM_ALLOC_KIND_NEW,
+                          NULL,
+                          true,
+                          __builtin_return_address(0));
+}
+
+// `operator new[](std::size_t, const std::nothrow_t &)`
+void *_ZnamRKSt9nothrow_t(size_t size, const void *tag) {
+    (void) tag;
+
+    return jm_preload_new(size,
+                          0,
+                          JM_ALLOC_KIND_NEW_ARRAY,
+                          NULL,
+                          true,
+                          __builtin_return_address(0));
+}
+
+// `operator new(std::size_t, std::align_val_t)`
+void *_ZnwmSt11align_val_t(size_t size, size_t alignment) {
+    return jm_preload_new(size,
+                          alignment,
+                          JM_ALLOC_KIND_NEW_ALIGNED,
+                          "_ZnwmSt11align_val_t",
+                          false,
+                          __builtin_return_address(0));
+}
+
+// `operator new[](std::size_t, std::align_val_t)`
+void *_ZnamSt11align_val_t(size_t size, size_t alignment) {
+    return jm_preload_new(size,
+                          alignment,
+                          JM_ALLOC_KIND_NEW_ARRAY_ALIGNED,
+                          "_ZnamSt11align_val_t",
+                          false,
+                          __builtin_return_address(0));
+}
+
+// `operator new(std::size_t, std::align_val_t, const std::nothrow_t &)`
+void *_ZnwmSt11align_val_tRKSt9nothrow_t(size_t size,
+                                         size_t alignment,
+                                         const void *tag) {
+    (void) tag;
+
+    return jm_preload_new(size,
+                          alignment,
+                          JM_ALLOC_KIND_NEW_ALIGNED,
+                          NULL,
+                          true,
+                          __builtin_return_address(0));
+}
+
+// `operator new[](std::size_t, std::align_val_t, const std::nothrow_t &)`
+void *_ZnamSt11align_val_tRKSt9nothrow_t(size_t size,
+                                         size_t alignment,
+                                         const void *tag) {
+    (void) tag;
+
+    return jm_preload_new(size,
+                          alignment,
+                          JM_ALLOC_KIND_NEW_ARRAY_ALIGNED,
+                          NULL,
+                          true,
+                          __builtin_return_address(0));
+}
+
+// `operator delete(void *)`
+void _ZdlPv(void *ptr) {
+    jm_preload_delete(ptr, 0, JM_ALLOC_KIND_NEW);
+}
+
+// `operator delete[](void *)`
+void _ZdaPv(void *ptr) {
+    jm_preload_delete(ptr, 0, JM_ALLOC_KIND_NEW_ARRAY);
+}
+
+// `operator delete(void *, std::size_t)`
+void _ZdlPvm(void *ptr, size_t size) {
+    jm_preload_delete(ptr, size, JM_ALLOC_KIND_NEW);
+}
+
+// `operator delete[](void *, std::size_t)`
+void _ZdaPvm(void *ptr, size_t size) {
+    jm_preload_delete(ptr, size, JM_ALLOC_KIND_NEW_ARRAY);
+}
+
+// `operator delete(void *, const std::nothrow_t &)`
+void _ZdlPvRKSt9nothrow_t(void *ptr, const void *tag) {
+    (void) tag;
+
+    jm_preload_delete(ptr, 0, JM_ALLOC_KIND_NEW);
+}
+
+// `operator delete[](void *, const std::nothrow_t &)`
+void _ZdaPvRKSt9nothrow_t(void *ptr, const void *tag) {
+    (void) tag;
+
+    jm_preload_delete(ptr, 0, JM_ALLOC_KIND_NEW_ARRAY);
+}
+
+// `operator delete(void *, std::align_val_t)`
+void _ZdlPvSt11align_val_t(void *ptr, size_t alignment) {
+    (void) alignment;
+
+    jm_preload_delete(ptr, 0, JM_ALLOC_KIND_NEW_ALIGNED);
+}
+
+// `operator delete[](void *, std::align_val_t)`
+void _ZdaPvSt11align_val_t(void *ptr, size_t alignment) {
+    (void) alignment;
+
+    jm_preload_delete(ptr, 0, JM_ALLOC_KIND_NEW_ARRAY_ALIGNED);
+}
+
+// `operator delete(void *, std::size_t, std::align_val_t)`
+void _ZdlPvmSt11align_val_t(void *ptr, size_t size, size_t alignment) {
+    (void) alignment;
+
+    jm_preload_delete(ptr, size, JM_ALLOC_KIND_NEW_ALIGNED);
+}
+
+// `operator delete[](void *, std::size_t, std::align_val_t)`
+void _ZdaPvmSt11align_val_t(void *ptr, size_t size, size_t alignment) {
+    (void) alignment;
+
+    jm_preload_delete(ptr, size, JM_ALLOC_KIND_NEW_ARRAY_ALIGNED);
+}
+
+// `operator delete(void *, std::align_val_t, const std::nothrow_t &)`
+void _ZdlPvSt11align_val_tRKSt9nothrow_t(void *ptr,
+                                         size_t alignment,
+                                         const void *tag) {
+    (void) alignment, (void) tag;
+
+    jm_preload_delete(ptr, 0, JM_ALLOC_KIND_NEW_ALIGNED);
+}
+
+// `operator delete[](void *, std::align_val_t, const std::nothrow_t &)`
+void _ZdaPvSt11align_val_tRKSt9nothrow_t(void *ptr,
+                                         size_t alignment,
+                                         const void *tag) {
+    (void) alignment, (void) tag;
+
+    jm_preload_delete(ptr, 0, JM_ALLOC_KIND_NEW_ARRAY_ALIGNED);
+}
+
+/* ========================================================================> */
+
+void *mmap(void *addr,
+           size_t length,
+           int prot,
+           int flags,
+           int fd,
+           off_t offset) {
+    if (libc_mmap == NULL) jm_preload_init();
+
+    void *result = libc_mmap(addr, length, prot, flags, fd, offset);
+
+    if (result == MAP_FAILED) return result;
+
+    if (jm_preload_is_tracked(mmap_key)) {
+        pthread_setspecific(mmap_key, &mmap_key);
+
+        jm_tracker_update_mappings();
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = JM_OPCODE_MAP,
+            .ptr = result,
+            .size = length,
+            .caller = __builtin_return_address(0) });
+
+        pthread_setspecific(mmap_key, NULL);
+    }
+
+    return result;
+}
+
+int munmap(void *addr, size_t length) {
+    if (libc_munmap == NULL) jm_preload_init();
+
+    /*
+        NOTE: Just like `free()`, the range is recorded as unmapped before
+        it is actually unmapped, so that another thread cannot map it 
+        again and record it first. `munmap()` only fails on arguments 
+        that are not page-aligned or empty, which are never recorded.
+    */
+
+    bool is_valid = (length > 0)
+                    && ((uintptr_t) addr % sysconf(_SC_PAGESIZE) == 0);
+
+    if (is_valid && jm_preload_is_tracked(munmap_key)) {
+        pthread_setspecific(munmap_key, &munmap_key);
+
+        jm_backtrace_unwind((jmEvent) { .opcode = JM_OPCODE_UNMAP,
+                                        .ptr = addr,
+                                        .size = length });
+
+        pthread_setspecific(munmap_key, NULL);
+    }
+
+    return libc_munmap(addr, length);
+}
+
+void *mremap(void *old_address,
+             size_t old_size,
+             size_t new_size,
+             int flags,
+             ...) {
+    if (libc_mremap == NULL) jm_preload_init();
+
+    void *new_address = NULL;
+
+    // NOTE: The fifth argument is only present if `MREMAP_FIXED` is set
+    if (flags & MREMAP_FIXED) {
+        va_list args;
+
+        va_start(args, flags);
+
+        new_address = va_arg(args, void *);
+
+        va_end(args);
+    }
+
+    bool is_tracked = jm_preload_is_tracked(mremap_key);
+
+    if (is_tracked) {
+        pthread_setspecific(mremap_key, &mremap_key);
+
+        jm_tracker_update_mappings();
+
+        // NOTE: A moved mapping releases its old range, see `realloc()`
+        jm_backtrace_lock();
+    }
+
+    void *result = libc_mremap(old_address,
+                               old_size,
+                               new_size,
+                               flags,
+                               new_address);
+
+    if (is_tracked) {
+        if (result != MAP_FAILED)
+            jm_backtrace_unwind((jmEvent) { .opcode = JM_OPCODE_REMAP,
+                                            .ptr = result,
+                                            .old_ptr = old_address,
+                                            .size = new_size,
+                                            .old_size = old_size });
+
+        jm_backtrace_unlock();
+
+        pthread_setspecific(mremap_key, NULL);
+    }
+
+    return result;
+}
+
+int brk(void *addr) {
+    if (libc_brk == NULL) jm_preload_init();
+
+    void *old_brk = libc_sbrk(0);
+
+    int result = libc_brk(addr);
+
+    if (result != 0 || old_brk == (void *) -1) return result;
+
+    if (jm_preload_is_tracked(brk_key)) {
+        pthread_setspecific(brk_key, &brk_key);
+
+        /*
+            NOTE: Moving the program break is treated as mapping 
+            (or unmapping) the pages between the old and new break.
+        */
+
+        bool is_growing = ((uintptr_t) addr > (uintptr_t) old_brk);
+
+        jm_tracker_update_mappings();
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = is_growing ? JM_OPCODE_MAP : JM_OPCODE_UNMAP,
+            .ptr = is_growing ? old_brk : addr,
+            .size = is_growing ? (uintptr_t) addr - (uintptr_t) old_brk
+                               : (uintptr_t) old_brk - (uintptr_t) addr,
+            .caller = __builtin_return_address(0) });
+
+        pthread_setspecific(brk_key, NULL);
+    }
+
+    return result;
+}
+
+void *sbrk(intptr_t increment) {
+    if (libc_sbrk == NULL) jm_preload_init();
+
+    void *result = libc_sbrk(increment);
+
+    if (result == (void *) -1 || increment == 0) return result;
+
+    if (jm_preload_is_tracked(sbrk_key)) {
+        pthread_setspecific(sbrk_key, &sbrk_key);
+
+        // NOTE: `sbrk()` returns the previous program break
+        bool is_growing = (increment > 0);
+
+        jm_tracker_update_mappings();
+        jm_backtrace_unwind((jmEvent) {
+            .opcode = is_growing ? JM_OPCODE_MAP : JM_OPCODE_UNMAP,
+            .ptr = is_growing ? result : (char *) result + increment,
+            .size = is_growing ? increment : -increment,
+            .caller = __builtin_return_address(0) });
+
+        pthread_setspecific(sbrk_key, NULL);
+    }
+
+    return result;
 }
 
 /* ========================================================================> */
@@ -218,7 +1028,10 @@ void *dlopen(const char *file, int mode) {
 
     void *result = libc_dlopen(file, mode);
 
-    if (result != NULL) jm_tracker_set_dirty(true);
+    if (result != NULL) {
+        jm_tracker_set_dirty(true);
+        jm_filter_set_dirty();
+    }
 
     return result;
 }
@@ -228,7 +1041,54 @@ int dlclose(void *handle) {
 
     int result = libc_dlclose(handle);
 
-    if (result == 0) jm_tracker_set_dirty(true);
+    if (result == 0) {
+        jm_tracker_set_dirty(true);
+        jm_filter_set_dirty();
+    }
+
+    return result;
+}
+
+/* ========================================================================> */
+
+int pthread_setname_np(pthread_t thread, const char *name) {
+    if (libc_pthread_setname_np == NULL) jm_preload_init();
+
+    int result = libc_pthread_setname_np(thread, name);
+
+    if (result == 0) {
+        jm_backtrace_set_names_dirty();
+        jm_filter_set_names_dirty();
+    }
+
+    return result;
+}
+
+int prctl(int option, ...) {
+    if (libc_prctl == NULL) jm_preload_init();
+
+    /*
+        NOTE: `prctl()` takes up to four more arguments, depending on
+        the option, and all of them are passed on as is.
+    */
+
+    va_list args;
+
+    va_start(args, option);
+
+    unsigned long arg2 = va_arg(args, unsigned long);
+    unsigned long arg3 = va_arg(args, unsigned long);
+    unsigned long arg4 = va_arg(args, unsigned long);
+    unsigned long arg5 = va_arg(args, unsigned long);
+
+    va_end(args);
+
+    int result = libc_prctl(option, arg2, arg3, arg4, arg5);
+
+    if (result == 0 && option == PR_SET_NAME) {
+        jm_backtrace_set_names_dirty();
+        jm_filter_set_names_dirty();
+    }
 
     return result;
 }
@@ -244,6 +1104,8 @@ PRINTF_VISIBILITY void putchar_(char c) {
 static void jm_preload_init_(void) {
     stm_setup();
 
+    jm_backtrace_init();
+
     assert(pthread_atfork(jm_preload_atfork_prepare,
                           jm_preload_atfork_parent,
                           jm_preload_atfork_child)
@@ -253,12 +1115,34 @@ static void jm_preload_init_(void) {
     jm_preload_malloc_init();
     jm_preload_realloc_init();
 
+    jm_preload_aligned_alloc_init();
+    jm_preload_memalign_init();
+    jm_preload_posix_memalign_init();
+    jm_preload_pvalloc_init();
+    jm_preload_reallocarray_init();
+    jm_preload_valloc_init();
+
     jm_preload_free_init();
 
+    jm_preload_new_init();
+    jm_preload_delete_init();
+
+    jm_preload_mmap_init();
+    jm_preload_munmap_init();
+    jm_preload_mremap_init();
+
+    jm_preload_brk_init();
+    jm_preload_sbrk_init();
+
     jm_preload_dlopen_init();
     jm_preload_dlclose_init();
 
-    unsetenv("LD_PRELOAD");
+    jm_preload_pthread_setname_np_init();
+    jm_preload_prctl_init();
+
+    // NOTE: Programs executed by this process are only profiled on request
+    if (getenv("JMPROF_FOLLOW") == NULL || getenv("JMPROF_FOLLOW")[0] == '0')
+        unsetenv("LD_PRELOAD");
 
     is_initialized = true;
 
@@ -270,27 +1154,110 @@ static void jm_preload_deinit_(void) {
     jm_preload_malloc_deinit();
     jm_preload_realloc_deinit();
 
+    jm_preload_aligned_alloc_deinit();
+    jm_preload_memalign_deinit();
+    jm_preload_posix_memalign_deinit();
+    jm_preload_pvalloc_deinit();
+    jm_preload_reallocarray_deinit();
+    jm_preload_valloc_deinit();
+
     jm_preload_free_deinit();
 
+    jm_preload_new_deinit();
+    jm_preload_delete_deinit();
+
+    jm_preload_mmap_deinit();
+    jm_preload_munmap_deinit();
+    jm_preload_mremap_deinit();
+
+    jm_preload_brk_deinit();
+    jm_preload_sbrk_deinit();
+
+    jm_backtrace_deinit();
+
     jm_preload_dlopen_deinit();
     jm_preload_dlclose_deinit();
 
+    jm_preload_pthread_setname_np_deinit();
+    jm_preload_prctl_deinit();
+
     is_initialized = false;
 }
 
+static bool jm_preload_is_tracked(pthread_key_t key) {
+    // NOTE: While the recording is paused, this is all we do for each call
+    return is_initialized && !jm_control_is_paused()
+           && (pthread_getspecific(key) == NULL);
+}
+
+static inline bool jm_preload_count(jmEvent event) {
+    /*
+        NOTE: In "histogram mode", events are only counted by their sizes,
+        before any of the work needed to record them is done.
+    */
+
+    if (!jm_histogram_is_enabled()) return false;
+
+    if (is_initialized && !jm_control_is_paused()) jm_histogram_count(event);
+
+    return true;
+}
 
 /* ========================================================================> */
 
 static void jm_preload_atfork_prepare(void) {
     is_initialized = false;
+
+    /*
+        NOTE: The locks must be taken in the same order as in the hooks:
+        the ones held while waiting for the unwinder first, then the 
+        unwinder's own, then the ones taken while it is held.
+    */
+
+    jm_tracker_atfork_prepare();
+    jm_filter_atfork_prepare();
+    jm_histogram_atfork_prepare();
+
+    jm_backtrace_atfork_prepare();
+
+    jm_filter_lock_blocks();
+    jm_tracker_lock();
 }
 
 static void jm_preload_atfork_parent(void) {
+    jm_tracker_unlock();
+    jm_filter_unlock_blocks();
+
+    jm_backtrace_atfork_parent();
+
+    jm_histogram_atfork_parent();
+    jm_filter_atfork_parent();
+    jm_tracker_atfork_parent();
+
     is_initialized = true;
 }
 
 static void jm_preload_atfork_child(void) {
-    jm_preload_deinit();
+    // NOTE: The child inherits the locks held by the thread that forked
+    jm_tracker_unlock();
+    jm_filter_unlock_blocks();
+
+    jm_backtrace_atfork_parent();
+
+    jm_histogram_atfork_parent();
+    jm_filter_atfork_child();
+    jm_tracker_atfork_parent();
+
+    jm_tracker_atfork_child();
+
+    if (!jm_tracker_is_following()) return;
+
+    jm_histogram_atfork_child();
+
+    // NOTE: The threads are named again in the stream of the child
+    jm_backtrace_set_names_dirty();
+
+    is_initialized = true;
 }
 
 /* ========================================================================> */
@@ -343,6 +1310,90 @@ static void jm_preload_realloc_deinit(void) {
     pthread_key_delete(realloc_key);
 }
 
+static void jm_preload_aligned_alloc_init(void) {
+    pthread_key_create(&aligned_alloc_key, NULL);
+
+    void *libc_aligned_alloc_ptr = dlsym(RTLD_NEXT, "aligned_alloc");
+
+    libc_aligned_alloc = libc_aligned_alloc_ptr;
+
+    assert(libc_aligned_alloc != NULL);
+}
+
+static void jm_preload_aligned_alloc_deinit(void) {
+    pthread_key_delete(aligned_alloc_key);
+}
+
+static void jm_preload_memalign_init(void) {
+    pthread_key_create(&memalign_key, NULL);
+
+    void *libc_memalign_ptr = dlsym(RTLD_NEXT, "memalign");
+
+    libc_memalign = libc_memalign_ptr;
+
+    assert(libc_memalign != NULL);
+}
+
+static void jm_preload_memalign_deinit(void) {
+    pthread_key_delete(memalign_key);
+}
+
+static void jm_preload_posix_memalign_init(void) {
+    pthread_key_create(&posix_memalign_key, NULL);
+
+    void *libc_posix_memalign_ptr = dlsym(RTLD_NEXT, "posix_memalign");
+
+    libc_posix_memalign = libc_posix_memalign_ptr;
+
+    assert(libc_posix_memalign != NULL);
+}
+
+static void jm_preload_posix_memalign_deinit(void) {
+    pthread_key_delete(posix_memalign_key);
+}
+
+static void jm_preload_pvalloc_init(void) {
+    pthread_key_create(&pvalloc_key, NULL);
+
+    void *libc_pvalloc_ptr = dlsym(RTLD_NEXT, "pvalloc");
+
+    libc_pvalloc = libc_pvalloc_ptr;
+
+    assert(libc_pvalloc != NULL);
+}
+
+static void jm_preload_pvalloc_deinit(void) {
+    pthread_key_delete(pvalloc_key);
+}
+
+static void jm_preload_reallocarray_init(void) {
+    pthread_key_create(&reallocarray_key, NULL);
+
+    void *libc_reallocarray_ptr = dlsym(RTLD_NEXT, "reallocarray");
+
+    libc_reallocarray = libc_reallocarray_ptr;
+
+    assert(libc_reallocarray != NULL);
+}
+
+static void jm_preload_reallocarray_deinit(void) {
+    pthread_key_delete(reallocarray_key);
+}
+
+static void jm_preload_valloc_init(void) {
+    pthread_key_create(&valloc_key, NULL);
+
+    void *libc_valloc_ptr = dlsym(RTLD_NEXT, "valloc");
+
+    libc_valloc = libc_valloc_ptr;
+
+    assert(libc_valloc != NULL);
+}
+
+static void jm_preload_valloc_deinit(void) {
+    pthread_key_delete(valloc_key);
+}
+
 static void jm_preload_free_init(void) {
     pthread_key_create(&free_key, NULL);
 
@@ -359,6 +1410,248 @@ static void jm_preload_free_deinit(void) {
 
 /* ========================================================================> */
 
+static void *jm_preload_new(size_t size,
+                            size_t alignment,
+                            jmAllocKind kind,
+                            const char *name,
+                            bool is_nothrow,
+                            const void *caller) {
+    if (libc_malloc == NULL) jm_preload_init();
+
+    // NOTE: `operator new` must return a unique pointer even if `size` is 0
+    if (size == 0) size = 1;
+
+    /*
+        NOTE: `posix_memalign()` refuses alignments smaller than a pointer,
+        which are valid for `operator new` (and rounded up by libstdc++).
+    */
+
+    if (alignment > 0 && alignment < sizeof(void *))
+        alignment = sizeof(void *);
+
+    void *result = NULL;
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    if (alignment > 0) {
+        if (libc_posix_memalign(&result, alignment, size) != 0) result = NULL;
+    } else {
+        result = libc_malloc(size);
+    }
+
+    uint64_t duration = jm_tracker_get_ticks() - start;
+
+    /*
+        NOTE: The real `operator new` calls the new-handler in a loop and
+        throws `std::bad_alloc` when there is none, which cannot be done
+        from C. We run the loop ourselves (so that the block is recorded
+        with the right kind), and leave the throwing to the real one.
+    */
+
+    while (result == NULL && !is_nothrow) {
+        /*
+            NOTE: This is looked up here rather than on initialization,
+            since `dlsym()` allocates an error message if the symbol is 
+            missing, as it is in programs not written in C++.
+        */
+
+        if (libcxx_get_new_handler == NULL) {
+            void *libcxx_get_new_handler_ptr = dlsym(RTLD_NEXT,
+                                                     "_ZSt15get_new_handlerv");
+
+            libcxx_get_new_handler = libcxx_get_new_handler_ptr;
+        }
+
+        void (*handler)(void) = (libcxx_get_new_handler != NULL)
+                                    ? libcxx_get_new_handler()
+                                    : NULL;
+
+        if (handler == NULL) {
+            void *libcxx_new_ptr = dlsym(RTLD_NEXT, name);
+
+            assert(libcxx_new_ptr != NULL);
+
+            // NOTE: glibc refuses any size larger than `PTRDIFF_MAX`
+            size_t max_size = (size_t) PTRDIFF_MAX + 1;
+
+            if (alignment > 0) {
+                void *(*libcxx_new)(size_t, size_t) = libcxx_new_ptr;
+
+                return libcxx_new(max_size, alignment);
+            } else {
+                void *(*libcxx_new)(size_t) = libcxx_new_ptr;
+
+                return libcxx_new(max_size);
+            }
+        }
+
+        handler();
+
+        start = jm_tracker_get_ticks();
+
+        if (alignment > 0) {
+            if (libc_posix_memalign(&result, alignment, size) != 0)
+                result = NULL;
+        } else {
+            result = libc_malloc(size);
+        }
+
+        duration += jm_tracker_get_ticks() - start;
+    }
+
+    if (result == NULL) return NULL;
+
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_ALLOC,
+                                     .ptr = result,
+                                     .size = size }))
+        return result;
+
+    if (jm_preload_is_tracked(new_key)) {
+        pthread_setspecific(new_key, &new_key);
+
+        jm_tracker_update_mappings();
+        jm_backtrace_unwind((jmEvent) { .opcode = JM_OPCODE_ALLOC,
+                                        .kind = kind,
+                                        .ptr = result,
+                                        .size = size,
+                                        .duration = duration,
+                                        .caller = caller });
+
+        pthread_setspecific(new_key, NULL);
+    }
+
+    return result;
+}
+
+static void jm_preload_delete(void *ptr, size_t size, jmAllocKind kind) {
+    if (libc_free == NULL) jm_preload_init();
+
+    if (jm_preload_count((jmEvent) { .opcode = JM_OPCODE_FREE,
+                                     .ptr = ptr,
+                                     .size = size })) {
+        libc_free(ptr);
+
+        return;
+    }
+
+    bool is_recorded = false;
+
+    if (jm_preload_is_tracked(delete_key)) {
+        pthread_setspecific(delete_key, &delete_key);
+
+        if (ptr != NULL)
+            is_recorded = jm_backtrace_unwind((jmEvent) {
+                .opcode = JM_OPCODE_FREE,
+                .kind = kind,
+                .ptr = ptr,
+                .size = size });
+
+        pthread_setspecific(delete_key, NULL);
+    }
+
+    if (!is_recorded || !jm_tracker_is_timing()) {
+        libc_free(ptr);
+
+        return;
+    }
+
+    uint64_t start = jm_tracker_get_ticks();
+
+    libc_free(ptr);
+
+    jm_backtrace_time_free(ptr, jm_tracker_get_ticks() - start);
+}
+
+static void jm_preload_new_init(void) {
+    pthread_key_create(&new_key, NULL);
+}
+
+static void jm_preload_new_deinit(void) {
+    pthread_key_delete(new_key);
+}
+
+static void jm_preload_delete_init(void) {
+    pthread_key_create(&delete_key, NULL);
+}
+
+static void jm_preload_delete_deinit(void) {
+    pthread_key_delete(delete_key);
+}
+
+/* ========================================================================> */
+
+static void jm_preload_mmap_init(void) {
+    pthread_key_create(&mmap_key, NULL);
+
+    void *libc_mmap_ptr = dlsym(RTLD_NEXT, "mmap");
+
+    libc_mmap = libc_mmap_ptr;
+
+    assert(libc_mmap != NULL);
+}
+
+static void jm_preload_mmap_deinit(void) {
+    pthread_key_delete(mmap_key);
+}
+
+static void jm_preload_munmap_init(void) {
+    pthread_key_create(&munmap_key, NULL);
+
+    void *libc_munmap_ptr = dlsym(RTLD_NEXT, "munmap");
+
+    libc_munmap = libc_munmap_ptr;
+
+    assert(libc_munmap != NULL);
+}
+
+static void jm_preload_munmap_deinit(void) {
+    pthread_key_delete(munmap_key);
+}
+
+static void jm_preload_mremap_init(void) {
+    pthread_key_create(&mremap_key, NULL);
+
+    void *libc_mremap_ptr = dlsym(RTLD_NEXT, "mremap");
+
+    libc_mremap = libc_mremap_ptr;
+
+    assert(libc_mremap != NULL);
+}
+
+static void jm_preload_mremap_deinit(void) {
+    pthread_key_delete(mremap_key);
+}
+
+static void jm_preload_brk_init(void) {
+    pthread_key_create(&brk_key, NULL);
+
+    void *libc_brk_ptr = dlsym(RTLD_NEXT, "brk");
+
+    libc_brk = libc_brk_ptr;
+
+    assert(libc_brk != NULL);
+}
+
+static void jm_preload_brk_deinit(void) {
+    pthread_key_delete(brk_key);
+}
+
+static void jm_preload_sbrk_init(void) {
+    pthread_key_create(&sbrk_key, NULL);
+
+    void *libc_sbrk_ptr = dlsym(RTLD_NEXT, "sbrk");
+
+    libc_sbrk = libc_sbrk_ptr;
+
+    assert(libc_sbrk != NULL);
+}
+
+static void jm_preload_sbrk_deinit(void) {
+    pthread_key_delete(sbrk_key);
+}
+
+/* ========================================================================> */
+
 static void jm_preload_dlopen_init(void) {
     void *libc_dlopen_ptr = dlsym(RTLD_NEXT, "dlopen");
 
@@ -382,3 +1675,29 @@ static void jm_preload_dlclose_init(void) {
 static void jm_preload_dlclose_deinit(void) {
     // TODO: ...
 }
+
+/* ========================================================================> */
+
+static void jm_preload_pthread_setname_np_init(void) {
+    void *libc_pthread_setname_np_ptr = dlsym(RTLD_NEXT, "pthread_setname_np");
+
+    libc_pthread_setname_np = libc_pthread_setname_np_ptr;
+
+    assert(libc_pthread_setname_np != NULL);
+}
+
+static void jm_preload_pthread_setname_np_deinit(void) {
+    // TODO: ...
+}
+
+static void jm_preload_prctl_init(void) {
+    void *libc_prctl_ptr = dlsym(RTLD_NEXT, "prctl");
+
+    libc_prctl = libc_prctl_ptr;
+
+    assert(libc_prctl != NULL);
+}
+
+static void jm_preload_prctl_deinit(void) {
+    // TODO: ...
+}
@@ -24,6 +24,7 @@
 
 #define _GNU_SOURCE
 
+#include <errno.h>
 #include <inttypes.h>
 #include <limits.h>
 #include <stdio.h>
@@ -34,8 +35,14 @@
 #include <fcntl.h>
 #include <libgen.h>
 #include <link.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <unistd.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #include "sokol_time.h"
 
 #include "jmprof.h"
@@ -52,6 +59,8 @@ static pthread_mutex_t is_disabled_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static pthread_mutex_t tracker_fd_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+static pthread_mutex_t scan_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* ========================================================================> */
 
 static char exec_path[PATH_MAX + 1];
@@ -60,9 +69,31 @@ static char exec_path[PATH_MAX + 1];
 
 static bool is_dirty = true;
 static bool is_disabled = false;
+static bool is_following = false;
+
+// NOTE: Only the first image of the first process writes to `FIFO`
+static bool is_original = false;
 
 static int tracker_fd = -1;
 
+/* ========================================================================> */
+
+static size_t page_size = 4096;
+
+static uint64_t scan_interval = 0, last_scan = 0;
+
+static int scan_count = 0;
+
+static volatile int scan_probe = 0;
+
+/* ========================================================================> */
+
+static bool is_timing = false;
+
+static uint64_t timing_ticks = 0, timing_time = 0;
+
+static uint64_t overhead_ticks = 0, overhead_count = 0;
+
 /* Private Function Prototypes ============================================> */
 
 static void jm_tracker_init_(void);
@@ -70,16 +101,26 @@ static void jm_tracker_deinit_(void);
 
 /* ========================================================================> */
 
-static void jm_tracker_atfork_prepare(void);
-static void jm_tracker_atfork_parent(void);
-static void jm_tracker_atfork_child(void);
+static void jm_tracker_open(void);
+static int jm_tracker_open_file(const char *fifo_path);
+static int jm_tracker_open_socket(const char *socket_path);
+
+/* ========================================================================> */
+
+static void jm_tracker_start_timing(void);
+static void jm_tracker_start_scans(void);
+static bool jm_tracker_clear_refs(void);
+static uint64_t jm_tracker_read_pagemap(int fd, const void *addr);
+static void jm_tracker_scan_region(int fd, jmRegion region);
+static void jm_tracker_write_cold_runs(const jmRegion *runs, size_t count);
 
 /* ========================================================================> */
 
 static int
 dl_iterate_phdr_callback(struct dl_phdr_info *info, size_t size, void *data);
 
-static size_t find_heap_regions(jmRegion *regions, size_t size);
+static size_t
+find_heap_regions(jmRegion *regions, size_t size, size_t *skipped);
 
 /* Public Functions =======================================================> */
 
@@ -93,6 +134,94 @@ void jm_tracker_deinit(void) {
 
 /* ========================================================================> */
 
+void jm_tracker_atfork_prepare(void) {
+    pthread_mutex_lock(&is_dirty_mutex);
+    pthread_mutex_lock(&scan_mutex);
+}
+
+void jm_tracker_atfork_parent(void) {
+    pthread_mutex_unlock(&scan_mutex);
+    pthread_mutex_unlock(&is_dirty_mutex);
+}
+
+void jm_tracker_atfork_child(void) {
+    /*
+        NOTE: The stream of the parent process must not be written to by
+        its children, so a child either opens a stream of its own, or 
+        stops writing altogether.
+    */
+
+    if (tracker_fd >= 0) (void) close(tracker_fd);
+
+    tracker_fd = -1, is_original = false;
+
+    if (!is_following) {
+        scan_interval = 0;
+
+        is_timing = false;
+
+        return;
+    }
+
+    jm_tracker_open();
+
+    jm_tracker_set_dirty(true);
+
+    if (is_timing) jm_tracker_start_timing();
+
+    // NOTE: The soft-dirty bits of the child are those of its parent
+    if (scan_interval > 0) {
+        scan_count = 0;
+
+        jm_tracker_start_scans();
+    }
+}
+
+/* ========================================================================> */
+
+void jm_tracker_lock(void) {
+    pthread_mutex_lock(&tracker_fd_mutex);
+}
+
+void jm_tracker_unlock(void) {
+    pthread_mutex_unlock(&tracker_fd_mutex);
+}
+
+/* ========================================================================> */
+
+bool jm_tracker_is_following(void) {
+    return is_following;
+}
+
+bool jm_tracker_is_timing(void) {
+    return is_timing;
+}
+
+/* ========================================================================> */
+
+uint64_t jm_tracker_get_ticks(void) {
+    if (!is_timing) return 0;
+
+    /*
+        NOTE: The time stamp counter is read in a few cycles, without a
+        system call (or even a call into the vDSO), and its ticks are 
+        converted to nanoseconds later on.
+    */
+
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return stm_now();
+#endif
+}
+
+void jm_tracker_add_overhead(uint64_t ticks) {
+    __atomic_fetch_add(&overhead_ticks, ticks, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&overhead_count, 1, __ATOMIC_RELAXED);
+}
+
+/* ========================================================================> */
+
 void jm_tracker_fprintf(const char *format, ...) {
     pthread_mutex_lock(&tracker_fd_mutex);
 
@@ -127,6 +256,13 @@ void jm_tracker_fprintf(const char *format, ...) {
     pthread_mutex_unlock(&tracker_fd_mutex);
 }
 
+void jm_tracker_write(const char *buffer, size_t size) {
+    // NOTE: This function must remain async-signal-safe
+    if (tracker_fd < 0) return;
+
+    (void) write(tracker_fd, buffer, size);
+}
+
 void jm_tracker_set_dirty(bool value) {
     if (pthread_mutex_trylock(&is_dirty_mutex) != 0) return;
 
@@ -136,30 +272,110 @@ void jm_tracker_set_dirty(bool value) {
 }
 
 void jm_tracker_update_mappings(void) {
+    // NOTE: Avoids contending for the lock on every single allocation
+    if (!__atomic_load_n(&is_dirty, __ATOMIC_RELAXED)) return;
+
     if (pthread_mutex_trylock(&is_dirty_mutex) != 0) return;
 
     {
-        if (!is_dirty) return;
-
-        is_dirty = false;
+        if (is_dirty) {
+            is_dirty = false;
 
-        (void) dl_iterate_phdr(dl_iterate_phdr_callback, NULL);
+            (void) dl_iterate_phdr(dl_iterate_phdr_callback, NULL);
+        }
     }
 
     pthread_mutex_unlock(&is_dirty_mutex);
 }
 
+void jm_tracker_scan_regions(void) {
+    if (scan_interval == 0) return;
+
+    uint64_t now = stm_now();
+
+    // NOTE: Avoids contending for the lock on every single allocation
+    if (now - __atomic_load_n(&last_scan, __ATOMIC_RELAXED) < scan_interval)
+        return;
+
+    if (pthread_mutex_trylock(&scan_mutex) != 0) return;
+
+    {
+        __atomic_store_n(&last_scan, now, __ATOMIC_RELAXED);
+
+        jmRegion regions[MAX_REGION_COUNT];
+
+        size_t skipped = 0;
+
+        size_t count = find_heap_regions(regions, MAX_REGION_COUNT, &skipped);
+
+        int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+
+        if (fd >= 0) {
+            jm_backtrace_lock();
+
+            // `<OPERATION> <ADDRESS> <SCAN_INDEX> <SKIPPED_REGIONS>`
+            jm_tracker_fprintf("%c 0x%jx %d %zu\n",
+                               JM_OPCODE_SCAN,
+                               NULL,
+                               ++scan_count,
+                               skipped);
+
+            jm_backtrace_unlock();
+
+            for (size_t i = 0; i < count; i++)
+                jm_tracker_scan_region(fd, regions[i]);
+
+            (void) close(fd);
+        }
+
+        // NOTE: The next scan only finds the pages not written from now on
+        (void) jm_tracker_clear_refs();
+    }
+
+    pthread_mutex_unlock(&scan_mutex);
+}
+
 /* Private Functions ======================================================> */
 
 static void jm_tracker_init_(void) {
-    if (readlink("/proc/self/exe", exec_path, PATH_MAX) == -1)
-        REENTRANT_SNPRINTF(exec_path, sizeof "unknown", "unknown");
+    const char *follow = getenv("JMPROF_FOLLOW");
 
-    const char *fifo_path = getenv("FIFO");
+    is_following = (follow != NULL && follow[0] != '\0' && follow[0] != '0');
 
-    tracker_fd = open(fifo_path, O_CLOEXEC | O_CREAT | O_WRONLY, (mode_t) 0644);
+    /*
+        NOTE: The process that was started first owns the original stream,
+        but once it calls `exec()`, the new program finds `JMPROF_PID` 
+        already set, and writes to a stream of its own.
+    */
 
-    jm_tracker_fprintf("%c 0x%jx %s\n", JM_OPCODE_EXEC_PATH, NULL, exec_path);
+    is_original = (getenv("JMPROF_PID") == NULL);
+
+    if (is_original) {
+        char pid[MAX_BUFFER_SIZE];
+
+        (void) REENTRANT_SNPRINTF(pid, sizeof pid, "%d", getpid());
+
+        (void) setenv("JMPROF_PID", pid, 1);
+    }
+
+    jm_tracker_open();
+
+    page_size = sysconf(_SC_PAGESIZE);
+
+    const char *timing = getenv("JMPROF_TIMING");
+
+    is_timing = (timing != NULL && timing[0] != '\0' && timing[0] != '0');
+
+    if (is_timing) jm_tracker_start_timing();
+
+    const char *interval = getenv("JMPROF_COLD_INTERVAL");
+
+    // NOTE: The scan interval is given in milliseconds
+    if (interval != NULL && strtoull(interval, NULL, 10) > 0) {
+        scan_interval = strtoull(interval, NULL, 10) * 1000000ULL;
+
+        jm_tracker_start_scans();
+    }
 }
 
 static void jm_tracker_deinit_(void) {
@@ -167,18 +383,271 @@ static void jm_tracker_deinit_(void) {
 
     jmRegion regions[MAX_REGION_COUNT];
 
-    for (int i = 0, j = find_heap_regions(regions, MAX_REGION_COUNT); i < j;
-         i++)
+    size_t count = find_heap_regions(regions, MAX_REGION_COUNT, NULL);
+
+    // NOTE: The other threads might still be writing their events
+    jm_backtrace_lock();
+
+    // `<OPERATION> <ADDRESS> <TICKS> <NANOSECONDS> <OVERHEAD> <EVENTS>`
+    if (is_timing)
+        jm_tracker_fprintf("%c 0x0 %ju %ju %ju %ju\n",
+                           JM_OPCODE_TIMING,
+                           jm_tracker_get_ticks() - timing_ticks,
+                           stm_now() - timing_time,
+                           overhead_ticks,
+                           overhead_count);
+
+    for (size_t i = 0; i < count; i++)
         jm_tracker_fprintf("%c 0x%jx 0x%jx\n",
                            JM_OPCODE_REGION,
                            (uintptr_t) regions[i].start,
                            (uintptr_t) regions[i].end);
 
+    jm_backtrace_unlock();
+
     assert(close(tracker_fd) == 0);
 }
 
 /* ========================================================================> */
 
+static void jm_tracker_open(void) {
+    if (readlink("/proc/self/exe", exec_path, PATH_MAX) == -1)
+        REENTRANT_SNPRINTF(exec_path, sizeof "unknown", "unknown");
+
+    const char *socket_path = getenv("JMPROF_SOCKET");
+
+    // NOTE: With a collector, every process connects to the same socket
+    tracker_fd = (socket_path != NULL) ? jm_tracker_open_socket(socket_path)
+                                       : jm_tracker_open_file(getenv("FIFO"));
+
+    jm_tracker_fprintf("%c 0x%jx %s\n", JM_OPCODE_EXEC_PATH, NULL, exec_path);
+
+    struct timespec ts;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    /*
+        NOTE: Timestamps are relative to the start of the process, so 
+        the clock base is needed to compare them with other streams.
+    */
+
+    uint64_t clock_base = (ts.tv_sec * 1000000000ULL + ts.tv_nsec) - stm_now();
+
+    // `<OPERATION> <ADDRESS> <PID> <PPID> <CLOCK_BASE>`
+    jm_tracker_fprintf("%c 0x%jx %d %d %" PRIu64 "\n",
+                       JM_OPCODE_PROCESS,
+                       NULL,
+                       getpid(),
+                       getppid(),
+                       clock_base);
+}
+
+static int jm_tracker_open_file(const char *fifo_path) {
+    if (fifo_path == NULL) return -1;
+
+    if (is_original)
+        return open(fifo_path,
+                    O_APPEND | O_CLOEXEC | O_CREAT | O_WRONLY,
+                    (mode_t) 0644);
+
+    /*
+        NOTE: Every other program in the tree writes to a stream of its 
+        own, named after the original stream and its process ID. 
+
+        The reader of a stream stops at the `exec()` that closes it, so 
+        a program that replaces another one never reopens its stream, 
+        but creates the next one in `<FIFO>.<PID>.1`, `<FIFO>.<PID>.2`...
+    */
+
+    char path[PATH_MAX + 1];
+
+    for (int i = 0; i < MAX_PROCESS_COUNT; i++) {
+        if (i == 0)
+            (void) REENTRANT_SNPRINTF(path,
+                                      sizeof path,
+                                      "%s.%d",
+                                      fifo_path,
+                                      getpid());
+        else
+            (void) REENTRANT_SNPRINTF(path,
+                                      sizeof path,
+                                      "%s.%d.%d",
+                                      fifo_path,
+                                      getpid(),
+                                      i);
+
+        int fd = open(path,
+                      O_APPEND | O_CLOEXEC | O_CREAT | O_EXCL | O_WRONLY,
+                      (mode_t) 0644);
+
+        if (fd >= 0 || errno != EEXIST) return fd;
+    }
+
+    return -1;
+}
+
+static int jm_tracker_open_socket(const char *socket_path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+    if (strlen(socket_path) >= sizeof addr.sun_path) return -1;
+
+    (void) strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) return -1;
+
+    if (connect(fd, (struct sockaddr *) &addr, sizeof addr) < 0) {
+        (void) close(fd);
+
+        return -1;
+    }
+
+    return fd;
+}
+
+/* ========================================================================> */
+
+static void jm_tracker_start_timing(void) {
+    overhead_ticks = overhead_count = 0;
+
+    timing_ticks = jm_tracker_get_ticks(), timing_time = stm_now();
+
+    // NOTE: How many nanoseconds a tick is worth is only known at exit
+    jm_tracker_fprintf("%c 0x0 0 0 0 0\n", JM_OPCODE_TIMING);
+}
+
+static void jm_tracker_start_scans(void) {
+    /*
+        NOTE: Soft-dirty bits are only tracked by kernels built with
+        `CONFIG_MEM_SOFT_DIRTY`, so a page is written right after the
+        bits are cleared, to see if the kernel notices.
+    */
+
+    uint64_t entry = 0;
+
+    if (jm_tracker_clear_refs()) {
+        int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+
+        if (fd >= 0) {
+            scan_probe++;
+
+            entry = jm_tracker_read_pagemap(fd, (const void *) &scan_probe);
+
+            (void) close(fd);
+        }
+    }
+
+    // NOTE: Bit 55 of a page map entry is set if the page is soft-dirty
+    if (((entry >> 55) & 1) == 0) {
+        scan_interval = 0;
+
+        return;
+    }
+
+    __atomic_store_n(&last_scan, stm_now(), __ATOMIC_RELAXED);
+}
+
+static bool jm_tracker_clear_refs(void) {
+    int fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+
+    if (fd < 0) return false;
+
+    // NOTE: "4" clears the soft-dirty bits of every page of the process
+    bool result = (write(fd, "4", 1) == 1);
+
+    (void) close(fd);
+
+    return result;
+}
+
+static uint64_t jm_tracker_read_pagemap(int fd, const void *addr) {
+    uint64_t entry = 0;
+
+    // NOTE: Each page has a 64-bit entry, indexed by its page number
+    off_t offset = ((uintptr_t) addr / page_size) * sizeof entry;
+
+    if (pread(fd, &entry, sizeof entry, offset) != sizeof entry) return 0;
+
+    return entry;
+}
+
+static void jm_tracker_scan_region(int fd, jmRegion region) {
+    uint64_t entries[MAX_PAGE_COUNT];
+
+    jmRegion runs[MAX_COLD_COUNT];
+
+    size_t run_count = 0;
+
+    uintptr_t addr = (uintptr_t) region.start, end = (uintptr_t) region.end;
+
+    uintptr_t cold_start = 0;
+
+    while (addr < end) {
+        size_t count = (end - addr) / page_size;
+
+        if (count > MAX_PAGE_COUNT) count = MAX_PAGE_COUNT;
+
+        off_t offset = (addr / page_size) * sizeof(uint64_t);
+
+        ssize_t ret = pread(fd, entries, count * sizeof(uint64_t), offset);
+
+        if (ret <= 0) break;
+
+        count = ret / sizeof(uint64_t);
+
+        for (size_t i = 0; i < count; i++, addr += page_size) {
+            /*
+                NOTE: A page is "cold" if it is in memory (bit 63) or 
+                swapped out (bit 62), but was not written since the bits
+                were last cleared (bit 55).
+            */
+
+            bool is_cold = ((entries[i] >> 62) & 3) != 0
+                           && ((entries[i] >> 55) & 1) == 0;
+
+            if (is_cold && cold_start == 0) cold_start = addr;
+
+            if (is_cold || cold_start == 0) continue;
+
+            runs[run_count++] = (jmRegion) { .start = (void *) cold_start,
+                                             .end = (void *) addr };
+
+            if (run_count == MAX_COLD_COUNT) {
+                jm_tracker_write_cold_runs(runs, run_count);
+
+                run_count = 0;
+            }
+
+            cold_start = 0;
+        }
+    }
+
+    if (cold_start != 0)
+        runs[run_count++] = (jmRegion) { .start = (void *) cold_start,
+                                         .end = (void *) addr };
+
+    jm_tracker_write_cold_runs(runs, run_count);
+}
+
+static void jm_tracker_write_cold_runs(const jmRegion *runs, size_t count) {
+    if (count == 0) return;
+
+    // NOTE: A cold run must not split an event from its backtrace
+    jm_backtrace_lock();
+
+    for (size_t i = 0; i < count; i++)
+        // `<OPERATION> <START_ADDRESS> <END_ADDRESS>`
+        jm_tracker_fprintf("%c 0x%jx 0x%jx\n",
+                           JM_OPCODE_COLD,
+                           (uintptr_t) runs[i].start,
+                           (uintptr_t) runs[i].end);
+
+    jm_backtrace_unlock();
+}
+
+/* ========================================================================> */
+
 static int
 dl_iterate_phdr_callback(struct dl_phdr_info *info, size_t size, void *data) {
     const char *dlpi_name = info->dlpi_name;
@@ -193,9 +662,16 @@ dl_iterate_phdr_callback(struct dl_phdr_info *info, size_t size, void *data) {
     return 0;
 }
 
-static size_t find_heap_regions(jmRegion *regions, size_t size) {
+static size_t
+find_heap_regions(jmRegion *regions, size_t size, size_t *skipped) {
     size_t result = 0UL;
 
+    // NOTE: The end of the previous mapping, if it was a guard page
+    uintptr_t guard_end = 0;
+
+    // NOTE: The end of the previous mapping, if it was backed by a file
+    uintptr_t file_end = 0;
+
     {
         FILE *fp = fopen("/proc/self/maps", "r");
 
@@ -204,11 +680,17 @@ static size_t find_heap_regions(jmRegion *regions, size_t size) {
         char addr[MMAP_ROW_SIZE], perms[MMAP_ROW_SIZE],
             device[MMAP_ROW_SIZE], path[MMAP_ROW_SIZE];
 
-        int ret, offset, inode;
+        unsigned long offset;
+
+        int ret, inode;
 
         while (fgets(buffer, sizeof buffer, fp) != NULL) {
+            // NOTE: An anonymous mapping has no path
+            path[0] = '\0';
+
+            // NOTE: The offset is written in hexadecimal
             int ret = sscanf(buffer,
-                             "%s %s %d %s %d %s",
+                             "%s %s %lx %s %d %s",
                              addr,
                              perms,
                              &offset,
@@ -225,14 +707,49 @@ static size_t find_heap_regions(jmRegion *regions, size_t size) {
                 as a private anonymous mapping using `mmap()`.
             */
 
-            if (ret < 5 || strncmp(path, "[heap]", sizeof "[heap]") == 0) {
-                if (result > size) continue;
+            bool is_anonymous = (ret == 5 && perms[1] == 'w');
+
+            uintptr_t start, end;
+
+            if (sscanf(addr, "%" SCNxPTR "-%" SCNxPTR, &start, &end) != 2)
+                continue;
+
+            /*
+                NOTE: The stack of a thread created by glibc is an anonymous 
+                mapping right above its guard page, and never holds a block.
+                The heaps of the other arenas can also follow an inaccessible
+                mapping, but they are aligned to `HEAP_MAX_SIZE` (1 MiB or 
+                more), unlike a stack, which starts a page after its mapping.
+            */
+
+            bool is_stack = is_anonymous && start == guard_end
+                            && (start % HEAP_ALIGNMENT) != 0;
+
+            /*
+                NOTE: The `.bss` section of a module (e.g. the tables of 
+                this library) is an anonymous mapping right after the last
+                mapping of its file, while the kernel places new mappings 
+                below the existing ones.
+            */
+
+            bool is_bss = is_anonymous && start == file_end;
+
+            guard_end = (ret == 5 && perms[0] == '-' && perms[1] == '-')
+                            ? end
+                            : 0;
+
+            file_end = (ret == 6 && path[0] == '/') ? end : 0;
+
+            if ((is_anonymous && !is_stack && !is_bss)
+                || strncmp(path, "[heap]", sizeof "[heap]") == 0) {
+                if (result >= size) {
+                    if (skipped != NULL) (*skipped)++;
+
+                    continue;
+                }
 
-                assert(sscanf(addr,
-                              "%p-%p",
-                              &regions[result].start,
-                              &regions[result].end)
-                       == 2);
+                regions[result].start = (void *) start;
+                regions[result].end = (void *) end;
 
                 result++;
             }